@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "sfo_cpp/sfo_concepts/element.hpp"
+#include "sfo_cpp/utils/lazy_heap.hpp"
+
+// Replays the queue traffic of a lazy greedy run on heap::LazyHeap and on the std::priority_queue based
+// LazyGreedyIdQueue it replaced, without any oracle, so only the queue is timed.
+// Run it with e.g. `bazel run -c opt //:benchmarks -- --benchmark_filter='LazyHeap|PriorityQueue'`.
+
+namespace
+{
+    double shrink(const uint32_t &id, const uint32_t &iteration)
+    {
+        // the factor a stale bound shrinks by when re-evaluated, the same for both queues
+        uint64_t x = (uint64_t(id) << 32 | iteration) * 0x9E3779B97F4A7C15ull;
+        x ^= x >> 29;
+        return 0.5 + 0.5 * double(x >> 11) / double(uint64_t(1) << 53);
+    }
+
+    std::vector<double> singletons(const uint32_t &n)
+    {
+        std::mt19937_64 rng(n); // same bounds on every run
+        std::uniform_real_distribution<double> uniform(0, 1);
+        std::vector<double> values(n);
+        for (auto &value : values)
+        {
+            value = uniform(rng);
+        }
+        return values;
+    }
+
+    void LazyHeapQueue(benchmark::State &state)
+    {
+        uint32_t n = uint32_t(state.range(0));
+        uint32_t k = uint32_t(state.range(1));
+        std::vector<double> values = singletons(n);
+        heap::LazyHeap marginals;
+        uint64_t reevaluations = 0;
+        for (auto _ : state)
+        {
+            marginals.clear();
+            for (uint32_t id = 0; id < n; id++)
+            {
+                marginals.append(id, values[id], 0);
+            }
+            marginals.heapify();
+            for (uint32_t iteration = 1; iteration <= k && !marginals.empty(); iteration++)
+            {
+                while (marginals.top_stamp() != iteration)
+                {
+                    marginals.update_top(marginals.top_value() * shrink(marginals.top_id(), iteration), iteration);
+                    reevaluations++;
+                }
+                marginals.pop();
+            }
+            benchmark::DoNotOptimize(marginals.size());
+        }
+        state.counters["reevaluations"] = benchmark::Counter(double(reevaluations), benchmark::Counter::kAvgIterations);
+    }
+
+    void PriorityQueue(benchmark::State &state)
+    {
+        uint32_t n = uint32_t(state.range(0));
+        uint32_t k = uint32_t(state.range(1));
+        std::vector<double> values = singletons(n);
+        std::vector<uint32_t> evaluated_at(n);
+        uint64_t reevaluations = 0;
+        for (auto _ : state)
+        {
+            std::vector<std::pair<uint32_t, double>> entries(n);
+            for (uint32_t id = 0; id < n; id++)
+            {
+                entries[id] = {id, values[id]};
+            }
+            std::fill(evaluated_at.begin(), evaluated_at.end(), 0);
+            LazyGreedyIdQueue marginals(compare_id_value_pair(), std::move(entries));
+            for (uint32_t iteration = 1; iteration <= k && !marginals.empty(); iteration++)
+            {
+                while (evaluated_at[marginals.top().first] != iteration)
+                {
+                    auto [id, value] = marginals.top();
+                    marginals.pop();
+                    evaluated_at[id] = iteration;
+                    marginals.push({id, value * shrink(id, iteration)});
+                    reevaluations++;
+                }
+                marginals.pop();
+            }
+            benchmark::DoNotOptimize(marginals.size());
+        }
+        state.counters["reevaluations"] = benchmark::Counter(double(reevaluations), benchmark::Counter::kAvgIterations);
+    }
+}
+
+BENCHMARK(LazyHeapQueue)->ArgsProduct({{10000, 1000000, 10000000}, {100, 1000}})->ArgNames({"n", "k"})->Unit(benchmark::kMillisecond);
+BENCHMARK(PriorityQueue)->ArgsProduct({{10000, 1000000, 10000000}, {100, 1000}})->ArgNames({"n", "k"})->Unit(benchmark::kMillisecond);
@@ -0,0 +1,533 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// include the algorithms we want
+#include "sfo_cpp/optimizers/monotone/vanilla_greedy.hpp"
+#include "sfo_cpp/optimizers/monotone/lazy_greedy.hpp"
+#include "sfo_cpp/optimizers/monotone/stochastic_greedy.hpp"
+#include "sfo_cpp/optimizers/monotone/lazier_than_lazy_greedy.hpp"
+#include "sfo_cpp/optimizers/monotone/threshold_greedy.hpp"
+#include "sfo_cpp/optimizers/monotone/preemption_streaming.hpp"
+#include "sfo_cpp/optimizers/monotone/greedi.hpp"
+#include "sfo_cpp/optimizers/monotone/static_greedy.hpp"
+#include "sfo_cpp/optimizers/non_monotone/bidirectional_greedy.hpp"
+#include "sfo_cpp/optimizers/streaming/sieve_streaming.hpp"
+
+// include the cost functions and constraints
+#include "sfo_cpp/sfo_concepts/ground_set.hpp"
+#include "sfo_cpp/sfo_concepts/cost_function.hpp"
+#include "sfo_cpp/sfo_concepts/facility_location.hpp"
+#include "sfo_cpp/sfo_concepts/coverage.hpp"
+#include "sfo_cpp/sfo_concepts/log_det.hpp"
+#include "sfo_cpp/sfo_concepts/constraint.hpp"
+
+// Elements are templated out, reuse the basic "element" class from the tests
+#include "sfo_cpp/tests/test_utils/demo_element.hpp"
+
+// Sweeps every optimizer over ground set size, budget, cost function and thread count.
+// Run a slice of it with e.g. `bazel run -c opt //:benchmarks -- --benchmark_filter='LazyGreedy/.*/n:1000000/'`.
+
+enum class Algorithm
+{
+    VANILLA_GREEDY,
+    LAZY_GREEDY,
+    STATIC_LAZY_GREEDY,
+    STOCHASTIC_GREEDY,
+    LAZIER_THAN_LAZY_GREEDY,
+    THRESHOLD_GREEDY,
+    GREEDI,
+    SIEVE_STREAMING,
+    PREEMPTION_STREAMING,
+    BIDIRECTIONAL_GREEDY
+};
+
+enum class Cost
+{
+    MODULAR,
+    SQRT_MODULAR,
+    FACILITY_LOCATION,
+    SPARSE_FACILITY_LOCATION,
+    WEIGHTED_COVERAGE,
+    LOG_DET
+};
+
+const char *algorithm_name(Algorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case Algorithm::VANILLA_GREEDY:
+        return "VanillaGreedy";
+    case Algorithm::LAZY_GREEDY:
+        return "LazyGreedy";
+    case Algorithm::STATIC_LAZY_GREEDY:
+        return "StaticLazyGreedy";
+    case Algorithm::STOCHASTIC_GREEDY:
+        return "StochasticGreedy";
+    case Algorithm::LAZIER_THAN_LAZY_GREEDY:
+        return "LazierThanLazyGreedy";
+    case Algorithm::THRESHOLD_GREEDY:
+        return "ThresholdGreedy";
+    case Algorithm::GREEDI:
+        return "GreeDi";
+    case Algorithm::SIEVE_STREAMING:
+        return "SieveStreaming";
+    case Algorithm::PREEMPTION_STREAMING:
+        return "PreemptionStreaming";
+    default:
+        return "BidirectionalGreedy";
+    }
+}
+
+const char *cost_name(Cost cost)
+{
+    switch (cost)
+    {
+    case Cost::MODULAR:
+        return "Modular";
+    case Cost::SQRT_MODULAR:
+        return "SqrtModular";
+    case Cost::FACILITY_LOCATION:
+        return "FacilityLocation";
+    case Cost::SPARSE_FACILITY_LOCATION:
+        return "SparseFacilityLocation";
+    case Cost::WEIGHTED_COVERAGE:
+        return "WeightedCoverage";
+    default:
+        return "LogDet";
+    }
+}
+
+// Largest ground set each cost function is built for (dense matrices grow with n^2 or n * rows).
+uint32_t max_size(Cost cost)
+{
+    switch (cost)
+    {
+    case Cost::FACILITY_LOCATION:
+        return 10000;
+    case Cost::LOG_DET:
+        return 1000;
+    default:
+        return 10000000;
+    }
+}
+
+// Largest ground set each optimizer is run on within a reasonable time.
+uint32_t max_size(Algorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case Algorithm::VANILLA_GREEDY:
+        return 1000000;
+    case Algorithm::BIDIRECTIONAL_GREEDY:
+        return 10000; // re-evaluates the top set from scratch every step
+    default:
+        return 10000000;
+    }
+}
+
+template <typename E>
+class CountingCost : public costfunction::CostFunction<E>
+{
+    // Forwards every oracle call to another cost function, counting them (gains counts one call per id).
+public:
+    costfunction::CostFunction<E> *inner;
+    std::atomic<uint64_t> calls{0};
+
+    CountingCost(costfunction::CostFunction<E> *F)
+    {
+        inner = F;
+    }
+
+    double evaluate(std::unordered_set<E *> &set)
+    {
+        calls++;
+        return inner->evaluate(set);
+    }
+
+    double evaluate(E *&el)
+    {
+        calls++;
+        return inner->evaluate(el);
+    }
+
+    std::unique_ptr<costfunction::OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+    {
+        return inner->new_state(V);
+    }
+
+    double gain(costfunction::OracleState<E> *state, E *el)
+    {
+        calls++;
+        return inner->gain(state, el);
+    }
+
+    void gains(costfunction::OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+    {
+        calls += count;
+        inner->gains(state, ids, count, out);
+    }
+
+    void commit(costfunction::OracleState<E> *state, E *el)
+    {
+        calls++;
+        inner->commit(state, el);
+    }
+};
+
+struct Problem
+{
+    Cost cost;
+    uint32_t n = 0;
+    std::vector<Element> elements;
+    groundset::GroundSet<Element> ground_set;
+    std::unique_ptr<costfunction::CostFunction<Element>> cost_function;
+};
+
+std::unique_ptr<Problem> make_problem(Cost cost, uint32_t n)
+{
+    std::unique_ptr<Problem> problem(new Problem);
+    problem->cost = cost;
+    problem->n = n;
+    problem->elements.resize(n);
+    for (uint32_t id = 0; id < n; id++)
+    {
+        problem->elements[id].id = int(id);
+        problem->ground_set.insert(&problem->elements[id]);
+    }
+
+    std::mt19937_64 rng(n); // same data on every run
+    std::uniform_real_distribution<double> uniform(0, 1);
+    groundset::GroundSet<Element> &V = problem->ground_set;
+
+    switch (cost)
+    {
+    case Cost::MODULAR:
+    case Cost::SQRT_MODULAR:
+    {
+        std::unordered_map<Element *, double> weights;
+        weights.reserve(n);
+        for (uint32_t id = 0; id < n; id++)
+        {
+            weights.insert({V[id], uniform(rng)});
+        }
+        costfunction::Modular<Element> modular(weights);
+        if (cost == Cost::MODULAR)
+        {
+            problem->cost_function.reset(new costfunction::Modular<Element>(modular));
+        }
+        else
+        {
+            problem->cost_function.reset(new costfunction::SqrtModular<Element>(modular));
+        }
+        break;
+    }
+    case Cost::FACILITY_LOCATION:
+    {
+        // 1000 random clients and n random facilities in the unit square, Gaussian similarity
+        uint32_t rows = 1000;
+        std::vector<double> x(rows + n), y(rows + n);
+        for (auto &coordinate : x)
+        {
+            coordinate = uniform(rng);
+        }
+        for (auto &coordinate : y)
+        {
+            coordinate = uniform(rng);
+        }
+        std::vector<double> similarity(std::size_t(rows) * n);
+        for (uint32_t i = 0; i < rows; i++)
+        {
+            for (uint32_t j = 0; j < n; j++)
+            {
+                double dx = x[i] - x[rows + j], dy = y[i] - y[rows + j];
+                similarity[std::size_t(i) * n + j] = std::exp(-10 * (dx * dx + dy * dy));
+            }
+        }
+        problem->cost_function.reset(new costfunction::FacilityLocation<Element>(V, similarity, rows));
+        break;
+    }
+    case Cost::SPARSE_FACILITY_LOCATION:
+    {
+        // every element covers its 10 nearest neighbours on a ring, with random similarities
+        std::vector<std::size_t> offsets = {0};
+        std::vector<uint32_t> neighbors;
+        std::vector<double> similarities;
+        neighbors.reserve(std::size_t(n) * 11);
+        similarities.reserve(std::size_t(n) * 11);
+        for (uint32_t j = 0; j < n; j++)
+        {
+            for (int d = -5; d <= 5; d++)
+            {
+                neighbors.push_back(uint32_t((int64_t(j) + n + d) % n));
+                similarities.push_back(uniform(rng) / (1 + std::abs(d)));
+            }
+            offsets.push_back(neighbors.size());
+        }
+        problem->cost_function.reset(new costfunction::SparseFacilityLocation<Element>(V, offsets, neighbors, similarities, n));
+        break;
+    }
+    case Cost::WEIGHTED_COVERAGE:
+    {
+        // every element covers 8 random items out of n / 4, with random item weights
+        uint32_t universe = std::max(n / 4, uint32_t(64));
+        std::uniform_int_distribution<uint32_t> item(0, universe - 1);
+        std::vector<std::vector<uint32_t>> covers(n);
+        for (auto &list : covers)
+        {
+            for (int k = 0; k < 8; k++)
+            {
+                list.push_back(item(rng));
+            }
+        }
+        std::vector<double> weights(universe);
+        for (auto &weight : weights)
+        {
+            weight = uniform(rng);
+        }
+        problem->cost_function.reset(new costfunction::WeightedCoverage<Element>(V, covers, universe, weights));
+        break;
+    }
+    case Cost::LOG_DET:
+    {
+        // Gaussian kernel over random points in the unit square
+        std::vector<double> x(n), y(n);
+        for (uint32_t j = 0; j < n; j++)
+        {
+            x[j] = uniform(rng);
+            y[j] = uniform(rng);
+        }
+        std::vector<double> kernel(std::size_t(n) * n);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            for (uint32_t j = 0; j < n; j++)
+            {
+                double dx = x[i] - x[j], dy = y[i] - y[j];
+                kernel[std::size_t(i) * n + j] = std::exp(-20 * (dx * dx + dy * dy));
+            }
+        }
+        problem->cost_function.reset(new costfunction::LogDet<Element>(V, kernel));
+        break;
+    }
+    }
+    return problem;
+}
+
+Problem &get_problem(Cost cost, uint32_t n)
+{
+    // benchmarks are registered so that runs on the same problem are consecutive, so keep just the last one
+    static std::unique_ptr<Problem> problem;
+    if (!problem || problem->cost != cost || problem->n != n)
+    {
+        problem.reset();
+        problem = make_problem(cost, n);
+    }
+    return *problem;
+}
+
+template <typename Optimizer>
+double run(Optimizer &optimizer, Problem &problem, costfunction::CostFunction<Element> *F, constraint::Constraint<Element> *C)
+{
+    optimizer.set_ground_set(&problem.ground_set);
+    optimizer.set_cost_function(F);
+    if (C)
+    {
+        optimizer.add_constraint(C);
+    }
+    optimizer.run_greedy();
+    return optimizer.curr_val;
+}
+
+template <typename ConcreteCost>
+double run_static(Problem &problem, constraint::Cardinality<Element> *C, uint64_t &calls)
+{
+    // the same lazy greedy with the cost function's concrete type known, so calls are counted by the optimizer
+    static_greedy::LazyGreedy<Element, ConcreteCost, constraint::Cardinality<Element>> optimizer(static_cast<ConcreteCost *>(problem.cost_function.get()), C);
+    optimizer.set_ground_set(&problem.ground_set);
+    optimizer.run_greedy();
+    calls = calls + optimizer.stats().oracle_evaluations;
+    return optimizer.curr_val;
+}
+
+double run_static(Problem &problem, Cost cost, constraint::Cardinality<Element> *C, uint64_t &calls)
+{
+    switch (cost)
+    {
+    case Cost::MODULAR:
+        return run_static<costfunction::Modular<Element>>(problem, C, calls);
+    case Cost::SQRT_MODULAR:
+        return run_static<costfunction::SqrtModular<Element>>(problem, C, calls);
+    case Cost::FACILITY_LOCATION:
+        return run_static<costfunction::FacilityLocation<Element>>(problem, C, calls);
+    case Cost::SPARSE_FACILITY_LOCATION:
+        return run_static<costfunction::SparseFacilityLocation<Element>>(problem, C, calls);
+    case Cost::WEIGHTED_COVERAGE:
+        return run_static<costfunction::WeightedCoverage<Element>>(problem, C, calls);
+    default:
+        return run_static<costfunction::LogDet<Element>>(problem, C, calls);
+    }
+}
+
+void benchmark_optimizer(benchmark::State &state, Algorithm algorithm, Cost cost, uint32_t n, int budget, int threads)
+{
+    Problem &problem = get_problem(cost, n);
+    CountingCost<Element> F(problem.cost_function.get());
+    constraint::Cardinality<Element> cardinality(budget);
+    double objective = 0;
+    uint64_t static_calls = 0; // oracle calls of the static optimizers, which cannot go through CountingCost
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto _ : state)
+    {
+        // a fresh optimizer every run, some of them keep state between runs
+        switch (algorithm)
+        {
+        case Algorithm::VANILLA_GREEDY:
+        {
+            VanillaGreedy<Element> optimizer;
+            optimizer.set_num_threads(threads);
+            objective = run(optimizer, problem, &F, &cardinality);
+            break;
+        }
+        case Algorithm::LAZY_GREEDY:
+        {
+            LazyGreedy<Element> optimizer;
+            optimizer.set_num_threads(threads);
+            optimizer.set_reevaluation_batch(threads > 1 ? 4 * threads : 1);
+            objective = run(optimizer, problem, &F, &cardinality);
+            break;
+        }
+        case Algorithm::STATIC_LAZY_GREEDY:
+        {
+            objective = run_static(problem, cost, &cardinality, static_calls);
+            break;
+        }
+        case Algorithm::STOCHASTIC_GREEDY:
+        {
+            StochasticGreedy<Element> optimizer;
+            optimizer.set_epsilon(0.1);
+            objective = run(optimizer, problem, &F, &cardinality);
+            break;
+        }
+        case Algorithm::LAZIER_THAN_LAZY_GREEDY:
+        {
+            LazierThanLazyGreedy<Element> optimizer;
+            optimizer.set_epsilon(0.1);
+            objective = run(optimizer, problem, &F, &cardinality);
+            break;
+        }
+        case Algorithm::THRESHOLD_GREEDY:
+        {
+            ThresholdGreedy<Element> optimizer;
+            optimizer.set_epsilon(0.1);
+            optimizer.set_num_threads(threads);
+            objective = run(optimizer, problem, &F, &cardinality);
+            break;
+        }
+        case Algorithm::GREEDI:
+        {
+            GreeDi<Element> optimizer;
+            optimizer.set_num_shards(std::max(threads, 4));
+            optimizer.set_num_threads(threads);
+            objective = run(optimizer, problem, &F, &cardinality);
+            break;
+        }
+        case Algorithm::SIEVE_STREAMING:
+        {
+            SieveStreaming<Element> optimizer;
+            optimizer.set_epsilon(0.1);
+            objective = run(optimizer, problem, &F, &cardinality);
+            break;
+        }
+        case Algorithm::PREEMPTION_STREAMING:
+        {
+            PreemptionStreaming<Element> optimizer;
+            objective = run(optimizer, problem, &F, &cardinality);
+            break;
+        }
+        case Algorithm::BIDIRECTIONAL_GREEDY:
+        {
+            BidirectionalGreedy<Element> optimizer;
+            objective = run(optimizer, problem, &F, nullptr);
+            break;
+        }
+        }
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    double calls = double(F.calls.load() + static_calls);
+    state.counters["oracle_calls"] = benchmark::Counter(calls, benchmark::Counter::kAvgIterations);
+    state.counters["ns_per_call"] = (calls > 0) ? elapsed / calls : 0;
+    state.counters["objective"] = objective;
+}
+
+void register_benchmarks()
+{
+    const Algorithm algorithms[] = {Algorithm::VANILLA_GREEDY, Algorithm::LAZY_GREEDY, Algorithm::STATIC_LAZY_GREEDY, Algorithm::STOCHASTIC_GREEDY, Algorithm::LAZIER_THAN_LAZY_GREEDY, Algorithm::THRESHOLD_GREEDY, Algorithm::GREEDI, Algorithm::SIEVE_STREAMING, Algorithm::PREEMPTION_STREAMING, Algorithm::BIDIRECTIONAL_GREEDY};
+    const Cost costs[] = {Cost::MODULAR, Cost::SQRT_MODULAR, Cost::FACILITY_LOCATION, Cost::SPARSE_FACILITY_LOCATION, Cost::WEIGHTED_COVERAGE, Cost::LOG_DET};
+    const int max_threads = std::max(2, int(std::thread::hardware_concurrency()));
+
+    // loop over the problem first, so get_problem only builds each one once
+    for (uint32_t n = 1000; n <= 10000000; n *= 10)
+    {
+        for (Cost cost : costs)
+        {
+            if (n > max_size(cost))
+            {
+                continue;
+            }
+            for (Algorithm algorithm : algorithms)
+            {
+                if (n > max_size(algorithm) || (algorithm == Algorithm::BIDIRECTIONAL_GREEDY && cost == Cost::LOG_DET))
+                {
+                    // bidirectional greedy would refactor the whole remaining kernel every step
+                    continue;
+                }
+                bool unconstrained = (algorithm == Algorithm::BIDIRECTIONAL_GREEDY);
+                bool parallel = (algorithm == Algorithm::VANILLA_GREEDY || algorithm == Algorithm::LAZY_GREEDY || algorithm == Algorithm::THRESHOLD_GREEDY || algorithm == Algorithm::GREEDI);
+                for (int budget : {10, 100})
+                {
+                    for (int threads : {1, max_threads})
+                    {
+                        if ((unconstrained && budget != 10) || (!parallel && threads != 1))
+                        {
+                            continue;
+                        }
+                        std::string name = std::string(algorithm_name(algorithm)) + "/" + cost_name(cost) + "/n:" + std::to_string(n);
+                        if (!unconstrained)
+                        {
+                            name = name + "/k:" + std::to_string(budget);
+                        }
+                        if (parallel)
+                        {
+                            name = name + "/threads:" + std::to_string(threads);
+                        }
+                        benchmark::RegisterBenchmark(name.c_str(), benchmark_optimizer, algorithm, cost, n, budget, threads)
+                            ->Unit(benchmark::kMillisecond)
+                            ->UseRealTime();
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    register_benchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
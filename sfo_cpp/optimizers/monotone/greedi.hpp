@@ -0,0 +1,258 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "../../sfo_concepts/element.hpp"
+#include "../../sfo_concepts/ground_set.hpp"
+#include "../../sfo_concepts/cost_function.hpp"
+#include "../../sfo_concepts/constraint.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/telemetry.hpp"
+#include "../../utils/stopping.hpp"
+#include "lazy_greedy.hpp"
+
+template <typename E>
+class GreeDi
+{
+    /* Two round partitioned greedy (Mirzasoleiman, Karbasi, Sarkar and Krause, 2013). The ground set is dealt
+     *  round-robin by id into num_shards shards, and LazyGreedy runs on every shard at once, each with its own
+     *  heap and oracle state. A final LazyGreedy then runs over the union of the shard solutions, and the better
+     *  of that merged solution and the best shard solution is kept. For a cardinality constraint k this is at
+     *  least (1 - 1/e)^2 / min(num_shards, k) of the optimum, and much closer in practice.
+     */
+private:
+    std::vector<groundset::GroundSet<E>> shard_sets; // the elements of each shard
+    std::vector<LazyGreedy<E>> shards;               // first round optimizer of each shard
+    groundset::GroundSet<E> merged_set;              // union of the shard solutions
+    LazyGreedy<E> merged;                            // second round optimizer
+    groundset::GroundSet<E> owned_ground_set;        // backs ground_set when handed a std::unordered_set
+    stopping::StoppingPolicy stopping_policy;        // handed to every round, none by default
+    int num_threads = 1;                             // shards run at once
+    std::unique_ptr<parallel::WorkerPool> pool;      // only started when num_threads > 1
+    telemetry::OptimizerStats run_stats;             // counters of both rounds, iterations of the second
+    telemetry::Tracer tracer;                        // optional trace sink, silent without one
+
+public:
+    double curr_val = 0; // current value of elements in set
+    bool constraint_saturated = false;
+    groundset::GroundSet<E> *ground_set = nullptr; // pointer to dense, id-indexed ground set of elements
+    int n = 0;                                     // holds size of ground set, indexed from 0 to n-1
+    std::unordered_set<constraint::Constraint<E> *> constraint_set;
+    costfunction::CostFunction<E> *cost_function = nullptr;
+    bool cost_benefit = false;
+    int num_shards = 1;               // m, how many parts the ground set is cut into
+    int best_shard = -1;              // shard whose solution was kept, or -1 for the merged one
+    double merged_val = 0;            // value of the second round's solution
+    std::unordered_set<E *> curr_set; // will hold elements selected to be in our set
+
+    void set_ground_set(groundset::GroundSet<E> *V)
+    {
+        this->ground_set = V;
+        this->n = V->size();
+    }
+
+    void set_ground_set(std::unordered_set<E *> *V)
+    {
+        // number the elements once, then work on the dense ground set
+        this->owned_ground_set = groundset::GroundSet<E>(*V);
+        this->set_ground_set(&(this->owned_ground_set));
+    }
+
+    void add_constraint(constraint::Constraint<E> *C)
+    {
+        this->constraint_set.insert(C);
+    }
+
+    void remove_constraint(constraint::Constraint<E> *C)
+    {
+        this->constraint_set.erase(C);
+    }
+
+    void set_cost_function(costfunction::CostFunction<E> *F)
+    {
+        this->cost_function = F;
+    }
+
+    void set_cost_benefit(bool cb)
+    {
+        this->cost_benefit = cb;
+    }
+
+    void set_num_shards(int m)
+    {
+        this->num_shards = std::max(1, m);
+    }
+
+    void set_num_threads(int threads)
+    {
+        /* Run up to threads shards at once, and the second round's first iteration on as many threads.
+         *  The result does not depend on the thread count, but the cost function's gain/gains and the
+         *  constraints must be safe to call concurrently (each shard has its own oracle and constraint states).
+         */
+        this->num_threads = std::max(1, threads);
+        this->pool.reset(this->num_threads > 1 ? new parallel::WorkerPool(this->num_threads) : nullptr);
+        this->merged.set_num_threads(this->num_threads);
+    }
+
+    const telemetry::OptimizerStats &stats() const
+    {
+        return this->run_stats;
+    }
+
+    void set_trace_sink(telemetry::TraceSink *sink)
+    {
+        // the second round's iterations and a run event for the whole run go to sink; nullptr silences them
+        this->tracer.sink = sink;
+    }
+
+    void set_stopping_policy(const stopping::StoppingPolicy &policy)
+    {
+        // every shard and the second round stop at the first of its limits
+        this->stopping_policy = policy;
+    }
+
+    stopping::StopReason stop_reason() const
+    {
+        // why the second round stopped
+        return this->merged.stop_reason();
+    }
+
+    const LazyGreedy<E> &shard(const int &s) const
+    {
+        // the first round optimizer of shard s, e.g. for its stats
+        return this->shards[s];
+    }
+
+    bool is_configured()
+    {
+        if (!this->ground_set)
+        {
+            std::cout << "No ground set given!" << std::endl;
+            return false;
+        }
+        else if (!this->cost_function)
+        {
+            std::cout << "No cost function given!" << std::endl;
+            return false;
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    void run_greedy()
+    {
+        if (!this->is_configured())
+        {
+            return;
+        }
+        run_stats.clear();
+
+        // first round: every shard on its own
+        this->partition();
+        auto run_shard = [&](int s)
+        {
+            this->configure(shards[s], &shard_sets[s]);
+            if (shard_sets[s].size() > 0)
+            {
+                shards[s].run_greedy();
+            }
+        };
+        if (pool)
+        {
+            pool->run(int(shards.size()), run_shard);
+        }
+        else
+        {
+            for (int s = 0; s < int(shards.size()); s++)
+            {
+                run_shard(s);
+            }
+        }
+
+        // second round: greedy over the union of the shard solutions, in shard order
+        merged_set = groundset::GroundSet<E>();
+        for (int s = 0; s < int(shards.size()); s++)
+        {
+            if (shard_sets[s].size() == 0)
+            {
+                continue;
+            }
+            run_stats.add_counts(shards[s].stats());
+            for (auto el : shard_sets[s].elements)
+            {
+                if (shards[s].curr_set.count(el) > 0)
+                {
+                    merged_set.insert(el);
+                }
+            }
+        }
+        this->configure(merged, &merged_set);
+        merged.set_trace_sink(tracer.sink);
+        curr_set.clear();
+        curr_val = 0;
+        constraint_saturated = false;
+        if (merged_set.size() > 0)
+        {
+            merged.run_greedy();
+            run_stats.add_counts(merged.stats());
+            run_stats.iterations = merged.stats().iterations;
+            curr_set = merged.curr_set;
+            curr_val = merged.curr_val;
+            constraint_saturated = merged.constraint_saturated;
+        }
+        merged_val = curr_val;
+
+        // keep the better of the merged solution and the best shard solution (the lowest shard on ties)
+        best_shard = -1;
+        for (int s = 0; s < int(shards.size()); s++)
+        {
+            if (shard_sets[s].size() > 0 && shards[s].curr_val > curr_val)
+            {
+                best_shard = s;
+                curr_set = shards[s].curr_set;
+                curr_val = shards[s].curr_val;
+                constraint_saturated = shards[s].constraint_saturated;
+            }
+        }
+        tracer.run("GreeDi", run_stats, curr_set.size(), curr_val);
+    };
+
+    void print_status(std::ostream &os = std::cout)
+    {
+        os << "Current set:" << curr_set << std::endl;
+        os << "Current val: " << curr_val << std::endl;
+        os << "Kept solution of " << ((best_shard < 0) ? "the merged round" : "shard " + std::to_string(best_shard)) << std::endl;
+        os << "Constraint saturated? " << constraint_saturated << std::endl;
+    };
+
+private:
+    void partition()
+    {
+        // deals ids out round-robin, so shards are balanced and keep the ground set's order
+        int m = std::max(1, std::min(num_shards, n));
+        shard_sets.assign(m, groundset::GroundSet<E>());
+        shards.resize(m);
+        for (int s = 0; s < m; s++)
+        {
+            shard_sets[s].elements.reserve(n / m + 1);
+        }
+        for (uint32_t id = 0; id < uint32_t(n); id++)
+        {
+            shard_sets[id % m].insert((*ground_set)[id]);
+        }
+    }
+
+    void configure(LazyGreedy<E> &optimizer, groundset::GroundSet<E> *V)
+    {
+        optimizer.set_ground_set(V);
+        optimizer.set_cost_function(cost_function);
+        optimizer.set_cost_benefit(cost_benefit);
+        optimizer.set_stopping_policy(stopping_policy);
+        optimizer.constraint_set = constraint_set;
+    }
+};
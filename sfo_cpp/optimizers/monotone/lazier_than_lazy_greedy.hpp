@@ -1,38 +1,61 @@
 #pragma once
-#include <queue>
+#include <algorithm>
 #include <unordered_set>
-#include <set>
 #include <iostream>
 #include <vector>
 #include <cfloat>
+#include <memory>
 #include "../../sfo_concepts/element.hpp"
+#include "../../sfo_concepts/ground_set.hpp"
 #include "../../sfo_concepts/cost_function.hpp"
 #include "../../sfo_concepts/constraint.hpp"
+#include "../../utils/telemetry.hpp"
+#include "../../utils/stopping.hpp"
+#include "../../utils/sampling.hpp"
+#include "../../utils/lazy_heap.hpp"
 
 template <typename E>
 class LazierThanLazyGreedy
 {
 private:
     int b;
-    int MAXITER = 15;
-    std::vector<E *> ground_set_idxs;          // this maps us from an integer to an element
-    std::unordered_map<E *, double> marginals; // will hold marginal values of all elements we have evaluated
+    stopping::StoppingPolicy stopping_policy; // limits of a run, none by default
+    groundset::GroundSet<E> owned_ground_set; // backs ground_set when handed a std::unordered_set
+    groundset::Membership in_set;             // ids of the elements in curr_set
+    std::unique_ptr<costfunction::OracleState<E>> oracle_state; // incremental oracle state of curr_set
+    sampling::IdSampler sampler;               // ids of the elements we can still sample
+    sampling::Rng rng;                         // reseeded with seed at the start of every run
+    std::vector<uint32_t> sample_set;          // ids drawn this iteration, reused across iterations
+    std::vector<double> bounds;                // upper bound on each id's marginal, DBL_MAX until first evaluated
+    uint32_t iteration = 0;                    // current greedy iteration
+    heap::LazyHeap sample_heap;                // bounds of the sample, reused every iteration
+    telemetry::OptimizerStats run_stats;       // counters of the last run
+    telemetry::Tracer tracer;                  // optional trace sink, silent without one
+    // running state of each constraint in constraint_set, so feasibility checks never look at curr_set
+    std::vector<std::pair<constraint::Constraint<E> *, std::unique_ptr<constraint::ConstraintState<E>>>> constraint_states;
 
 public:
     double curr_val = 0; // current value of elements in set
     bool constraint_saturated = false;
-    std::unordered_set<E *> *ground_set;
-    int n = 0; // holds size of ground set, indexed from 0 to n-1
+    groundset::GroundSet<E> *ground_set = nullptr; // pointer to dense, id-indexed ground set of elements
+    int n = 0;                                     // holds size of ground set, indexed from 0 to n-1
     std::unordered_set<constraint::Constraint<E> *> constraint_set;
-    costfunction::CostFunction<E> *cost_function;
+    costfunction::CostFunction<E> *cost_function = nullptr;
     std::unordered_set<E *> curr_set; // will hold elements selected to be in our set
     double epsilon = 0;
+    uint64_t seed = sampling::DEFAULT_SEED; // runs with the same seed draw the same samples
 
-    void set_ground_set(std::unordered_set<E *> *V)
+    void set_ground_set(groundset::GroundSet<E> *V)
     {
         this->ground_set = V;
         this->n = V->size();
-        this->index_ground_set();
+    }
+
+    void set_ground_set(std::unordered_set<E *> *V)
+    {
+        // number the elements once, then work on the dense ground set
+        this->owned_ground_set = groundset::GroundSet<E>(*V);
+        this->set_ground_set(&(this->owned_ground_set));
     }
 
     void add_constraint(constraint::Constraint<E> *C)
@@ -52,10 +75,11 @@ public:
         this->constraint_set.erase(C);
     }
 
-    bool check_constraints(std::unordered_set<E *> set)
+    bool check_constraints(std::unordered_set<E *> &set)
     {
         for (auto iter = constraint_set.begin(); iter != constraint_set.end(); ++iter)
         {
+            run_stats.constraint_checks++;
             if (!((*iter)->test_membership(set)))
             {
                 // if any constraint is not satisfied, then intersection of them is not
@@ -65,7 +89,7 @@ public:
         return true; // if all constraints were satisfied, then return true
     }
 
-    bool check_saturated(std::unordered_set<E *> set)
+    bool check_saturated(std::unordered_set<E *> &set)
     {
         for (auto iter = constraint_set.begin(); iter != constraint_set.end(); ++iter)
         {
@@ -88,10 +112,44 @@ public:
         this->epsilon = epsilon;
     }
 
+    void set_seed(uint64_t seed)
+    {
+        this->seed = seed;
+    }
+
+    const telemetry::OptimizerStats &stats() const
+    {
+        return this->run_stats;
+    }
+
+    void set_trace_sink(telemetry::TraceSink *sink)
+    {
+        // per-iteration events (and, at TraceLevel::DEBUG, the current set) go to sink; nullptr silences them
+        this->tracer.sink = sink;
+    }
+
+    void set_stopping_policy(const stopping::StoppingPolicy &policy)
+    {
+        // a run stops at the first of its limits, or when no element can be added
+        this->stopping_policy = policy;
+    }
+
+    stopping::StopReason stop_reason() const
+    {
+        return this->stopping_policy.reason;
+    }
+
     void clear_set()
     {
         this->curr_set.clear();
+        this->in_set.resize(this->n);
+        this->reset_constraint_states();
         this->curr_val = 0;
+        if (this->cost_function)
+        {
+            this->oracle_state = this->cost_function->new_state(this->ground_set);
+            this->curr_val = this->oracle_state->value;
+        }
         this->constraint_saturated = false;
         this->clear_marginals();
     }
@@ -101,193 +159,212 @@ public:
         this->index_ground_set();
     }
 
+    bool is_configured()
+    {
+        if (!this->ground_set)
+        {
+            std::cout << "No ground set given!" << std::endl;
+            return false;
+        }
+        else if (!this->cost_function)
+        {
+            std::cout << "No cost function given!" << std::endl;
+            return false;
+        }
+        else if (!find_single_cardinality())
+        {
+            // stochastic greedy is only valid for cardinality constraints, so check
+            std::cout << "Constraint is not a cardinality constraint, stochastic greedy is not valid." << std::endl;
+            return false;
+        }
+        else
+        {
+            return true;
+        }
+    }
+
     void run_greedy()
     {
-        // stochastic greedy is only valid for cardinality constraints, so check
         if (epsilon <= 0)
         {
             std::cout << "Epsilon is not set/valid, using default value of 0.05..." << std::endl;
             this->epsilon = 0.05;
         }
-        if (constraint::Cardinality<E> *k = find_single_cardinality(); k != nullptr)
+        if (this->is_configured())
         {
-            this->b = k->budget;
-            this->curr_val = 0;
+            this->b = find_single_cardinality()->budget;
+            this->clear_set(); // also puts every id back into the sampler
+            this->run_stats.clear();
+            this->stopping_policy.start();
+            this->rng.seed(this->seed);
             // first, compute how many samples to randomly pull at each step
-            int sample_size = compute_random_set_size();
-            std::unordered_set<E *> *sample_set = new std::unordered_set<E *>;
-            LazyGreedyQueue<E> sample_marginals;
+            uint32_t sample_size = compute_random_set_size();
+            sample_heap.reserve(sample_size);
             int counter = 0;
-            while (!constraint_saturated && counter < MAXITER)
+            while (!constraint_saturated && !stopping_policy.reached(run_stats, curr_set.size(), curr_val))
             {
                 counter++;
-                *sample_set = sample_ground_set(sample_size); // we need to sample the valid marginals now, not full ground set
-                std::cout << "Sampled set: " << *sample_set << std::endl;
-                sample_marginals = sample_to_marginals(sample_set);
-                lazier_than_lazy_greedy_step(sample_marginals);
-                update_marginals(sample_marginals);
-                sample_size = std::min(sample_size, int(marginals.size()));
-                std::cout << "Performed greedy algorithm iteration: " << counter << std::endl;
-                print_status();
+                telemetry::IterationTimer timer;
+                double prev_val = curr_val;
+                sampler.draw(sample_size, rng, sample_set); // only ids that are still candidates are left to draw
+                run_stats.samples_drawn = run_stats.samples_drawn + sample_set.size();
+                tracer.debug([&](auto &os)
+                             {
+                                 os << "Sampled set: ";
+                                 this->print_sample(sample_set, os); });
+                lazier_than_lazy_greedy_step();
+                if (stopping_policy.reason != stopping::StopReason::NONE)
+                {
+                    break; // abandoned midway, nothing was added
+                }
+                timer.record(run_stats, curr_val - prev_val);
+                trace_iteration("LazierThanLazyGreedy", counter);
             }
-        }
-        else
-        {
-            std::cout << "Constraint is not a cardinality constraint, stochastic greedy is not valid." << std::endl;
+            tracer.run("LazierThanLazyGreedy", run_stats, curr_set.size(), curr_val);
         }
     };
 
-    void print_status()
+    void print_status(std::ostream &os = std::cout)
     {
-        std::cout << "Current set:";
-        std::cout << curr_set;
-        std::cout << "Current val: " << curr_val << std::endl;
-        std::cout << "Constraint saturated? " << constraint_saturated << std::endl;
+        os << "Current set:";
+        os << curr_set;
+        os << "Current val: " << curr_val << std::endl;
+        os << "Constraint saturated? " << constraint_saturated << std::endl;
     };
 
 private:
-    int compute_random_set_size()
+    void trace_iteration(const char *optimizer, const int &counter)
     {
-        return int(std::min((double(this->n) / this->b) * log(1.0 / this->epsilon), double(this->n)));
+        tracer.iteration(optimizer, counter, run_stats, curr_set.size(), curr_val, constraint_saturated);
+        tracer.debug([&](auto &os)
+                     { this->print_status(os); });
     }
 
-    void index_ground_set()
+    uint32_t compute_random_set_size()
     {
-        int idx = 0;
-        for (auto el = ground_set->begin(); el != ground_set->end(); ++el, ++idx)
-        {
-            ground_set_idxs.push_back(*el);
-            marginals.insert({*el, DBL_MAX});
-        }
+        return std::max(1u, uint32_t(std::min((double(this->n) / this->b) * log(1.0 / this->epsilon), double(this->n))));
     }
 
-    std::unordered_set<E *> sample_ground_set(int &set_size)
+    void index_ground_set()
     {
-        std::unordered_set<E *> random_set;
-        E *candidate;
-        int rand_idx;
-        int count = 0;
-        // main sampling loop
-        while (count < set_size)
-        {
-            rand_idx = rand() % ground_set_idxs.size(); // pull a random index between 0 and n
-            candidate = ground_set_idxs[rand_idx];      // find which element pointer it corresponds to
-            // first see if we have added it to the set already
-            if (random_set.find(candidate) == random_set.end())
-            {
-                if (marginals.find(candidate) == marginals.end())
-                {
-                    // if there is no associated marginal, then it is no longer feasible
-                    ground_set_idxs.erase(ground_set_idxs.begin() + rand_idx);
-                }
-                else
-                {
-                    random_set.insert(ground_set_idxs[rand_idx]);
-                    count++; // increment number of elements in our set
-                }
-            }
-            else
-            {
-                continue;
-            }
-        }
-        return random_set;
+        sampler.reset(this->n);
+        bounds.assign(this->n, DBL_MAX);
+        iteration = 0;
     }
 
-    LazyGreedyQueue<E> sample_to_marginals(std::unordered_set<E *> *sample_set)
+    void print_sample(std::vector<uint32_t> &sample_set, std::ostream &os)
     {
-        LazyGreedyQueue<E> sample_marginals;
-        std::pair<E *, double> marginal;
-        for (auto it : *sample_set)
+        os << "{";
+        for (auto id : sample_set)
         {
-            marginal.first = it;
-            if (marginals.find(it) != marginals.end())
-            {
-                marginal.second = marginals[it];
-            }
-            else
-            {
-                marginal.second = DBL_MAX;
-            }
-            sample_marginals.push(marginal);
+            os << *(*ground_set)[id] << ",";
         }
-        return sample_marginals;
+        os << "}";
     }
 
-    void update_marginals(LazyGreedyQueue<E> sampled_marginals)
+    void lazier_than_lazy_greedy_step()
     {
-        // helper function
-        // updates the running total marginals with the sampled set
-        std::pair<E *, double> candidate;
-        while (!sampled_marginals.empty())
+        iteration++;
+
+        // heapify the sample's bounds, none of which was computed in this iteration yet
+        sample_heap.clear();
+        for (auto id : sample_set)
         {
-            candidate = sampled_marginals.top();
-            marginals[candidate.first] = candidate.second;
-            sampled_marginals.pop();
+            sample_heap.append(id, bounds[id], 0);
         }
-    }
+        sample_heap.heapify();
+        run_stats.queue_pushes = run_stats.queue_pushes + sample_heap.size();
 
-    void lazier_than_lazy_greedy_step(LazyGreedyQueue<E> &sampled_marginals)
-    {
-        std::unordered_set<E *> test_set(curr_set);
-        std::pair<E *, double> candidate;
-
-        // iterate through all candidate element IDs
-        while (!sampled_marginals.empty())
+        // until the top of the heap has been evaluated this iteration, its bound may be stale
+        while (!sample_heap.empty() && sample_heap.top_stamp() != iteration)
         {
-            test_set = curr_set;
-
-            // pull first element from priority queue
-            candidate.first = sampled_marginals.top().first;
-            test_set.insert(candidate.first); // add it to testing set
+            uint32_t id = sample_heap.top_id();
+            E *el = (*ground_set)[id];
 
-            if (!this->check_constraints(test_set))
+            if (!this->can_add(el, run_stats.constraint_checks))
             {
-                sampled_marginals.pop();
-                marginals.erase(candidate.first); // leave that element out from now on
+                sample_heap.pop();
+                run_stats.queue_pops++;
+                sampler.discard(id); // leave that element out from now on
                 continue;
             }
 
-            candidate.second = cost_function->evaluate(test_set) - curr_val;
-
-            // put updated candidate back into priority queue
-            sampled_marginals.pop();
-            sampled_marginals.push(candidate);
-
-            // if it is still at the top, we have found best element
-            if (sampled_marginals.top().second <= candidate.second)
+            if (stopping_policy.interrupt(run_stats.oracle_evaluations + 1))
             {
-                break;
+                return; // a hard limit was hit, the step is abandoned
             }
+
+            bounds[id] = cost_function->gain(oracle_state.get(), el);
+            run_stats.oracle_evaluations++;
+            run_stats.reevaluations++;
+
+            // update the candidate's bound in place
+            sample_heap.update_top(bounds[id], iteration);
+            run_stats.queue_updates++;
         }
 
-        if (!sampled_marginals.empty())
+        if (!sample_heap.empty() && sample_heap.top_value() >= 0)
         {
-            if (auto best = sampled_marginals.top(); best.second > 0)
-            {
-                // update the current set, value, and budget value with the found item
-                curr_set.insert(best.first);
-                curr_val = curr_val + best.second;
-                sampled_marginals.pop();
-                constraint_saturated = this->check_saturated(curr_set); // allows for early stop detection
-            }
-            else
-            {
-                if (marginals.empty())
-                {
-                    constraint_saturated = true;
-                }
-            }
+            // like stochastic greedy, a zero gain still takes up the budget, so every iteration adds an element
+            uint32_t best = sample_heap.top_id();
+            this->add_to_set((*ground_set)[best]);
+            sampler.discard(best); // selected elements are no longer candidates
+            run_stats.queue_pops++;
         }
-        else
+        else if (!sample_heap.empty())
+        {
+            // the best fresh gain in the sample is negative, stop as stochastic greedy does
+            constraint_saturated = true;
+        }
+        else if (sampler.size() == 0)
         {
             // we are really only at feasible limit if we have nothing left to sample
-            if (marginals.empty())
+            constraint_saturated = true;
+        }
+    };
+
+    void reset_constraint_states()
+    {
+        constraint_states.clear();
+        for (auto C : constraint_set)
+        {
+            constraint_states.push_back({C, C->new_state()});
+        }
+    }
+
+    bool can_add(E *el, uint64_t &checks)
+    {
+        // checks el against every constraint's running state, counting the checks
+        for (auto &[C, state] : constraint_states)
+        {
+            checks++;
+            if (!C->can_add(state.get(), el))
             {
-                constraint_saturated = true;
+                return false;
             }
         }
-    };
+        return true;
+    }
+
+    void commit_constraints(E *el)
+    {
+        // updates every constraint's running state, and whether any of them is now saturated
+        constraint_saturated = false;
+        for (auto &[C, state] : constraint_states)
+        {
+            C->commit(state.get(), el);
+            constraint_saturated = constraint_saturated || C->saturated(state.get());
+        }
+    }
+
+    void add_to_set(E *el)
+    {
+        curr_set.insert(el);
+        in_set.insert(ground_set->id(el));
+        cost_function->commit(oracle_state.get(), el);
+        curr_val = oracle_state->value;
+        this->commit_constraints(el); // allows for early stop detection
+    }
 
     constraint::Cardinality<E> *find_single_cardinality()
     {
@@ -0,0 +1,276 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+#include "../../sfo_concepts/element.hpp"
+#include "../../sfo_concepts/ground_set.hpp"
+#include "../../sfo_concepts/cost_function.hpp"
+#include "../../sfo_concepts/constraint.hpp"
+#include "../../utils/telemetry.hpp"
+
+template <typename E>
+class PreemptionStreaming
+{
+    /* Single pass streaming with preemption under a cardinality constraint k (Chakrabarti and Kale, 2015;
+     *  Buchbinder, Feldman and Schwartz, 2015), keeping a single buffer of at most k elements. Marginals are
+     *  taken against the set of every element ever let in, preempted ones included, which only grows, so one
+     *  incremental oracle state serves the whole stream. Each member carries its weight, the marginal it had when
+     *  it was let in. Until the buffer is full every element with a positive marginal is let in. After that, an
+     *  element whose marginal is at least replacement_factor times the smallest weight preempts that member.
+     *  With factor 2 this is a 1/4 approximation.
+     *
+     *  An arrival costs one marginal, plus one commit if it is let in. The buffer's own value is not tracked
+     *  along the way: solution() (and so run_greedy) evaluates it, at one more oracle call.
+     */
+private:
+    std::vector<E *> members;                                   // the buffer, at most k elements
+    std::vector<double> weights;                                // marginal of each member when it was let in
+    std::size_t weakest = 0;                                    // position of the smallest weight
+    std::unique_ptr<costfunction::OracleState<E>> oracle_state; // incremental oracle state of every element let in
+    uint32_t k = 0;                                             // cardinality budget
+    groundset::GroundSet<E> owned_ground_set;                   // backs ground_set when handed a std::unordered_set
+    telemetry::OptimizerStats run_stats;                        // counters since the last clear_set
+    telemetry::LatencyStats arrival_latency;                    // processing time of each pushed element
+    telemetry::Tracer tracer;                                   // optional trace sink, silent without one
+
+public:
+    double curr_val = 0;                           // value of the buffer, as of the last solution()
+    uint64_t num_seen = 0;                         // elements pushed since the last clear_set
+    uint64_t num_swaps = 0;                        // members preempted since the last clear_set
+    groundset::GroundSet<E> *ground_set = nullptr; // optional, streamed in id order by run_greedy
+    std::unordered_set<constraint::Constraint<E> *> constraint_set;
+    costfunction::CostFunction<E> *cost_function = nullptr;
+    double replacement_factor = 2;    // how much larger than the weakest weight a marginal must be to preempt
+    std::unordered_set<E *> curr_set; // will hold the elements in the buffer
+
+    void set_ground_set(groundset::GroundSet<E> *V)
+    {
+        this->ground_set = V;
+    }
+
+    void set_ground_set(std::unordered_set<E *> *V)
+    {
+        this->owned_ground_set = groundset::GroundSet<E>(*V);
+        this->set_ground_set(&(this->owned_ground_set));
+    }
+
+    void add_constraint(constraint::Constraint<E> *C)
+    {
+        this->constraint_set.insert(C);
+    }
+
+    void remove_constraint(constraint::Constraint<E> *C)
+    {
+        this->constraint_set.erase(C);
+    }
+
+    void set_cost_function(costfunction::CostFunction<E> *F)
+    {
+        this->cost_function = F;
+    }
+
+    void set_replacement_factor(double factor)
+    {
+        this->replacement_factor = factor;
+    }
+
+    const telemetry::OptimizerStats &stats() const
+    {
+        // only counters, a stream has no iterations to time
+        return this->run_stats;
+    }
+
+    const telemetry::LatencyStats &latency() const
+    {
+        return this->arrival_latency;
+    }
+
+    void set_trace_sink(telemetry::TraceSink *sink)
+    {
+        // a run event at the end of run_greedy and consume (and, at TraceLevel::DEBUG, the buffer) go to sink
+        this->tracer.sink = sink;
+    }
+
+    bool is_configured()
+    {
+        if (!this->cost_function)
+        {
+            std::cout << "No cost function given!" << std::endl;
+            return false;
+        }
+        else if (!(find_single_cardinality() && constraint_set.size() == 1))
+        {
+            std::cout << "Constraint is not a single cardinality constraint, preemption streaming is not valid." << std::endl;
+            return false;
+        }
+        else if (!(this->replacement_factor >= 1))
+        {
+            std::cout << "Preemption streaming needs a replacement factor of at least 1!" << std::endl;
+            return false;
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    void clear_set()
+    {
+        // forget the stream so far, the next push starts a new one
+        this->members.clear();
+        this->weights.clear();
+        this->weakest = 0;
+        this->curr_set.clear();
+        this->curr_val = 0;
+        this->num_seen = 0;
+        this->num_swaps = 0;
+        this->run_stats.clear();
+        this->arrival_latency.clear();
+        if (this->cost_function)
+        {
+            this->oracle_state = this->cost_function->new_state(); // the empty set, so also the buffer's value
+            this->curr_val = this->oracle_state->value;
+        }
+        constraint::Cardinality<E> *C = find_single_cardinality();
+        this->k = C ? uint32_t(std::max(0.0, C->budget)) : 0;
+        this->members.reserve(this->k);
+        this->weights.reserve(this->k);
+    }
+
+    void push(E *el)
+    {
+        // one element of the stream, which is not looked at again
+        if (!oracle_state)
+        {
+            if (!this->is_configured())
+            {
+                return;
+            }
+            this->clear_set();
+        }
+        auto start = std::chrono::steady_clock::now();
+        num_seen++;
+
+        run_stats.constraint_checks++;
+        if (k > 0 && curr_set.count(el) == 0)
+        {
+            double gain = cost_function->gain(oracle_state.get(), el);
+            run_stats.oracle_evaluations++;
+            if (members.size() < k)
+            {
+                if (gain > 0)
+                {
+                    this->let_in(el, gain);
+                }
+            }
+            else if (gain > 0 && gain >= replacement_factor * weights[weakest])
+            {
+                this->preempt(el, gain);
+            }
+        }
+
+        arrival_latency.record(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    template <typename Iterator>
+    void consume(Iterator begin, Iterator end)
+    {
+        // pushes every element of [begin, end), e.g. a batch read off the stream
+        for (; begin != end; ++begin)
+        {
+            this->push(*begin);
+        }
+        this->trace_run("PreemptionStreaming");
+    }
+
+    void run_greedy()
+    {
+        // streams the ground set once, in id order, so the optimizer can stand in for the offline ones
+        if (!this->ground_set)
+        {
+            std::cout << "No ground set given!" << std::endl;
+            return;
+        }
+        if (this->is_configured())
+        {
+            this->clear_set();
+            this->consume(ground_set->elements.begin(), ground_set->elements.end());
+            this->solution();
+        }
+    }
+
+    std::unordered_set<E *> &solution()
+    {
+        // the buffer, after evaluating its value into curr_val
+        if (oracle_state)
+        {
+            curr_val = cost_function->evaluate(curr_set);
+            run_stats.oracle_evaluations++;
+        }
+        return curr_set;
+    }
+
+    void print_status(std::ostream &os = std::cout)
+    {
+        os << "Current set:";
+        os << curr_set;
+        os << "Current val: " << curr_val << std::endl;
+        os << "Elements seen: " << num_seen << ", swaps: " << num_swaps << std::endl;
+        os << "Mean latency: " << arrival_latency.mean_seconds() << "s, max: " << arrival_latency.max_seconds << "s" << std::endl;
+    };
+
+private:
+    void trace_run(const char *optimizer)
+    {
+        if (tracer.enabled(telemetry::TraceLevel::RUN))
+        {
+            this->solution(); // the buffer's value is only worth an oracle call when someone is listening
+        }
+        tracer.run(optimizer, run_stats, curr_set.size(), curr_val);
+        tracer.debug([&](auto &os)
+                     { this->print_status(os); });
+    }
+
+    void let_in(E *el, const double &gain)
+    {
+        members.push_back(el);
+        weights.push_back(gain);
+        curr_set.insert(el);
+        cost_function->commit(oracle_state.get(), el);
+        if (weights[members.size() - 1] < weights[weakest])
+        {
+            weakest = members.size() - 1;
+        }
+    }
+
+    void preempt(E *el, const double &gain)
+    {
+        // el takes the weakest member's place, and stays in the state of everything let in
+        curr_set.erase(members[weakest]);
+        curr_set.insert(el);
+        members[weakest] = el;
+        weights[weakest] = gain;
+        num_swaps++;
+        cost_function->commit(oracle_state.get(), el);
+        weakest = std::size_t(std::min_element(weights.begin(), weights.end()) - weights.begin());
+    }
+
+    constraint::Cardinality<E> *find_single_cardinality()
+    {
+        constraint::Cardinality<E> *cardinality_ptr;
+        for (auto it = constraint_set.begin(); it != constraint_set.end(); ++it)
+        {
+            // iterate over constraints in set, looking for one that can be cast to cardinality
+            cardinality_ptr = dynamic_cast<constraint::Cardinality<E> *>(*it);
+            if (cardinality_ptr != nullptr)
+            {
+                return cardinality_ptr;
+            }
+        }
+        return nullptr;
+    }
+};
@@ -0,0 +1,888 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../../sfo_concepts/element.hpp"
+#include "../../sfo_concepts/ground_set.hpp"
+#include "../../sfo_concepts/cost_function.hpp"
+#include "../../sfo_concepts/constraint.hpp"
+#include "../../sfo_concepts/static_dispatch.hpp"
+#include "../../utils/lazy_heap.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/telemetry.hpp"
+#include "../../utils/stopping.hpp"
+#include "../../utils/solution_path.hpp"
+
+namespace static_greedy
+{
+    /* The greedy optimizers, templated on the concrete cost function and constraint types, e.g.
+     *  static_greedy::LazyGreedy<E, costfunction::SqrtModular<E>, constraint::Cardinality<E>>. Every gain and
+     *  feasibility check is a direct call the compiler can inline. The type-erased VanillaGreedy<E> and
+     *  LazyGreedy<E> are these same classes over CostFunction<E> and an Intersection of the constraints added at
+     *  run time (see TypeErased below), where every call is virtual instead.
+     */
+
+    template <typename E, typename Cost, typename... Constraints>
+        requires dispatch::IncrementalCostFunction<Cost, E> && (dispatch::StatefulConstraint<Constraints, E> && ...)
+    class GreedyCore
+    {
+        // what the greedy optimizers share: configuration, the solution and its oracle and constraint states
+    protected:
+        static constexpr std::size_t NUM_CONSTRAINTS = sizeof...(Constraints);
+
+        stopping::StoppingPolicy stopping_policy; // limits of a run, none by default
+        groundset::GroundSet<E> owned_ground_set; // backs ground_set when handed a std::unordered_set
+        groundset::Membership in_set;             // ids of the elements in curr_set
+        std::unique_ptr<costfunction::OracleState<E>> oracle_state;                                   // incremental oracle state of curr_set
+        std::tuple<Constraints *...> constraints;                                                      // the constraints, all of which must hold
+        std::array<std::unique_ptr<constraint::ConstraintState<E>>, NUM_CONSTRAINTS> constraint_states; // their running states
+        constraint::Knapsack<E> *knapsack = nullptr;                                                   // weighs elements in cost-benefit runs
+        uint32_t BATCH_SIZE = 256;                                                                     // candidates handed to the batch oracle at once
+        int num_threads = 1;                                                                           // threads evaluating marginals
+        std::unique_ptr<parallel::WorkerPool> pool;                                                    // only started when num_threads > 1
+        telemetry::OptimizerStats run_stats;                                                           // counters of the last run
+        telemetry::Tracer tracer;                                                                      // optional trace sink, silent without one
+        solution::SolutionPath<E> selection_path;                                                      // selection order of the last run
+
+    public:
+        double curr_val = 0; // current value of elements in set
+        bool constraint_saturated = false;
+        groundset::GroundSet<E> *ground_set = nullptr; // pointer to dense, id-indexed ground set of elements
+        int n = 0;                                     // holds size of ground set, indexed from 0 to n-1
+        Cost *cost_function = nullptr;
+        bool cost_benefit = false;
+        std::unordered_set<E *> curr_set; // will hold elements selected to be in our set
+
+        GreedyCore() {}
+
+        GreedyCore(Cost *F, Constraints *...C) : constraints(C...)
+        {
+            this->cost_function = F;
+        }
+
+        void set_ground_set(groundset::GroundSet<E> *V)
+        {
+            this->ground_set = V;
+            this->n = V->size();
+        }
+
+        void set_ground_set(std::unordered_set<E *> *V)
+        {
+            // number the elements once, then work on the dense ground set
+            this->owned_ground_set = groundset::GroundSet<E>(*V);
+            this->set_ground_set(&(this->owned_ground_set));
+        }
+
+        void set_cost_function(Cost *F)
+        {
+            this->cost_function = F;
+        }
+
+        void set_constraints(Constraints *...C)
+        {
+            this->constraints = std::tuple<Constraints *...>(C...);
+        }
+
+        void set_cost_benefit(bool cb)
+        {
+            this->cost_benefit = cb;
+        }
+
+        void set_num_threads(int threads)
+        {
+            /* Evaluate marginals on several threads: each step's scan for VanillaGreedy, the first iteration and
+             *  batches of stale marginals for LazyGreedy. The result does not depend on the thread count (ties go
+             *  to the lowest id), but the cost function's gain/gains and the constraints must be safe to call
+             *  concurrently.
+             */
+            this->num_threads = std::max(1, threads);
+            this->pool.reset(this->num_threads > 1 ? new parallel::WorkerPool(this->num_threads) : nullptr);
+        }
+
+        const telemetry::OptimizerStats &stats() const
+        {
+            return this->run_stats;
+        }
+
+        const solution::SolutionPath<E> &path() const
+        {
+            // what the last run selected, in order, with the gain and value of each step
+            return this->selection_path;
+        }
+
+        void set_trace_sink(telemetry::TraceSink *sink)
+        {
+            // per-iteration events (and, at TraceLevel::DEBUG, the current set) go to sink; nullptr silences them
+            this->tracer.sink = sink;
+        }
+
+        void set_stopping_policy(const stopping::StoppingPolicy &policy)
+        {
+            // a run stops at the first of its limits, or when no element can be added
+            this->stopping_policy = policy;
+        }
+
+        stopping::StopReason stop_reason() const
+        {
+            return this->stopping_policy.reason;
+        }
+
+        bool is_configured()
+        {
+            bool all_constraints = std::apply([](auto *...C)
+                                              { return ((C != nullptr) && ...); },
+                                              constraints);
+            if (!this->ground_set)
+            {
+                std::cout << "No ground set given!" << std::endl;
+                return false;
+            }
+            else if (!this->cost_function)
+            {
+                std::cout << "No cost function given!" << std::endl;
+                return false;
+            }
+            else if (!all_constraints)
+            {
+                std::cout << "Not every constraint given!" << std::endl;
+                return false;
+            }
+            else if (this->cost_benefit && !this->find_knapsack())
+            {
+                std::cout << "Requested CB greedy with invalid constraint type." << std::endl;
+                return false;
+            }
+            else
+            {
+                return true;
+            }
+        }
+
+        void clear_set()
+        {
+            this->curr_set.clear();
+            this->in_set.resize(this->n);
+            if (this->cost_function)
+            {
+                this->oracle_state = dispatch::new_state(*cost_function, ground_set);
+                this->curr_val = this->oracle_state->value;
+            }
+            else
+            {
+                this->oracle_state.reset();
+                this->curr_val = 0;
+            }
+            this->constraint_saturated = false;
+            this->selection_path.clear(ground_set, curr_val);
+            std::apply([&](auto *...C)
+                       {
+                std::size_t i = 0;
+                ((constraint_states[i++] = C ? dispatch::constraint_state<E>(*C) : nullptr), ...); },
+                       constraints);
+            this->knapsack = this->cost_benefit ? this->find_knapsack() : nullptr;
+        }
+
+        void print_status(std::ostream &os = std::cout)
+        {
+            os << "Current set:";
+            os << curr_set;
+            os << "Current val: " << curr_val << std::endl;
+            os << "Constraint saturated? " << constraint_saturated << std::endl;
+        };
+
+    protected:
+        void trace_iteration(const char *optimizer, const int &counter)
+        {
+            tracer.iteration(optimizer, counter, run_stats, curr_set.size(), curr_val, constraint_saturated);
+            tracer.debug([&](auto &os)
+                         { this->print_status(os); });
+        }
+
+        template <typename Fn>
+        void for_each_constraint(Fn fn)
+        {
+            // fn(constraint, its running state) for every constraint, looking inside intersections
+            std::apply([&](auto *...C)
+                       {
+                std::size_t i = 0;
+                ((C ? dispatch::for_each_constraint(*C, constraint_states[i].get(), fn) : void(), i++), ...); },
+                       constraints);
+        }
+
+        constraint::Knapsack<E> *find_knapsack()
+        {
+            // the first knapsack among the constraints, found by type where it can be
+            constraint::Knapsack<E> *found = nullptr;
+            std::apply([&](auto *...C)
+                       { ((found = (found || !C) ? found : find_in(*C)), ...); },
+                       constraints);
+            return found;
+        }
+
+        bool can_add(E *el, uint64_t &checks)
+        {
+            // checks el against every constraint's running state in turn, counting the checks
+            return std::apply([&](auto *...C)
+                              {
+                std::size_t i = 0;
+                return (dispatch::can_add(*C, constraint_states[i++].get(), el, checks) && ...); },
+                              constraints);
+        }
+
+        void add_to_set(uint32_t id)
+        {
+            // updates the set, its value, every constraint's running state, and whether any of them is saturated
+            E *el = (*ground_set)[id];
+            curr_set.insert(el);
+            in_set.insert(id);
+            dispatch::commit(*cost_function, oracle_state.get(), el);
+            curr_val = oracle_state->value;
+            selection_path.record(id, curr_val);
+            constraint_saturated = false;
+            std::apply([&](auto *...C)
+                       {
+                std::size_t i = 0;
+                ((dispatch::commit(*C, constraint_states[i].get(), el),
+                  constraint_saturated = dispatch::saturated(*C, constraint_states[i].get()) || constraint_saturated,
+                  i++),
+                 ...); },
+                       constraints);
+        }
+
+        double knapsack_cost(E *el)
+        {
+            // marginal knapsack cost of a modular knapsack, only asked for by cost-benefit runs
+            return knapsack->modular.weight(el);
+        }
+
+        bool spend(std::atomic<uint64_t> &spent, const uint32_t &count, stopping::StopReason &stopped)
+        {
+            /* Claims count more oracle calls for a scan split across threads, which have spent spent so far.
+             *  Unless that passes a hard limit of the stopping policy, in which case stopped says which and the
+             *  caller abandons its part of the scan.
+             */
+            stopped = this->stopping_policy.hard_limit(run_stats.oracle_evaluations + (spent += count));
+            return stopped == stopping::StopReason::NONE;
+        }
+
+        bool abandoned(const stopping::StopReason &stopped)
+        {
+            // after a split scan: whether any part of it hit a hard limit, which then ends the run
+            if (stopped != stopping::StopReason::NONE && this->stopping_policy.reason == stopping::StopReason::NONE)
+            {
+                this->stopping_policy.reason = stopped;
+            }
+            return this->stopping_policy.reason != stopping::StopReason::NONE;
+        }
+
+        void run_tasks(int num_tasks, const std::function<void(int)> &fn)
+        {
+            if (pool)
+            {
+                pool->run(num_tasks, fn);
+            }
+            else
+            {
+                for (int i = 0; i < num_tasks; i++)
+                {
+                    fn(i);
+                }
+            }
+        }
+
+    private:
+        template <typename T>
+        constraint::Knapsack<E> *find_in(T &C)
+        {
+            constraint::Knapsack<E> *found = nullptr;
+            dispatch::for_each_constraint(C, (constraint::ConstraintState<E> *)nullptr, [&](auto *member, auto)
+                                          { found = found ? found : dispatch::cast<constraint::Knapsack<E>>(member); });
+            return found;
+        }
+    };
+
+    template <typename E, typename Cost, typename... Constraints>
+    class VanillaGreedy : public GreedyCore<E, Cost, Constraints...>
+    {
+        // the greedy algorithm, scanning every feasible element each iteration
+    public:
+        using GreedyCore<E, Cost, Constraints...>::GreedyCore;
+
+        void run_greedy()
+        {
+            if (!this->is_configured())
+            {
+                return;
+            }
+            this->clear_set();
+            this->run_stats.clear();
+            this->stopping_policy.start();
+            const char *name = this->cost_benefit ? "CostBenefitVanillaGreedy" : "VanillaGreedy";
+            int counter = 0;
+            while (!this->constraint_saturated && !this->stopping_policy.reached(this->run_stats, this->curr_set.size(), this->curr_val))
+            {
+                counter++;
+                telemetry::IterationTimer timer;
+                double prev_val = this->curr_val;
+                greedy_step();
+                if (this->stop_reason() != stopping::StopReason::NONE)
+                {
+                    break; // abandoned midway, nothing was added
+                }
+                timer.record(this->run_stats, this->curr_val - prev_val);
+                this->trace_iteration(name, counter);
+            }
+            this->tracer.run(name, this->run_stats, this->curr_set.size(), this->curr_val);
+        }
+
+    private:
+        struct Slice
+        {
+            // scratch space and running winner of one contiguous range of ids scanned by one thread
+            std::vector<uint32_t> batch_ids;  // feasible candidates waiting for evaluation
+            std::vector<double> batch_gains;  // their marginal gains
+            std::vector<double> batch_costs;  // their marginal knapsack costs (cost-benefit only)
+            uint32_t best_id = 0;
+            double best_marginal_val = -DBL_MAX;
+            double best_marginal_cost = 1;
+            telemetry::OptimizerStats counts;                        // this slice's share of the step's counters
+            stopping::StopReason stopped = stopping::StopReason::NONE; // set if a hard limit cut the slice short
+        };
+        std::vector<Slice> slices;
+
+        void greedy_step()
+        {
+            // adds the best element by marginal value or, in cost-benefit runs, by marginal value per marginal cost
+            uint32_t best_id = 0;
+            double best_marginal_val = -DBL_MAX;
+            double best_marginal_cost = 1;
+            if (!this->scan_ground_set(best_id, best_marginal_val, best_marginal_cost))
+            {
+                return; // a hard limit was hit, the step is abandoned
+            }
+
+            // check if we could even add an element to set
+            if (best_marginal_val < 0)
+            {
+                this->constraint_saturated = true; // no more elements could be feasibly added
+            }
+            else
+            {
+                this->add_to_set(best_id);
+            }
+        }
+
+        bool scan_ground_set(uint32_t &best_id, double &best_marginal_val, double &best_marginal_cost)
+        {
+            /* Find the best feasible element not yet in curr_set, unless a hard limit cuts the scan short. The ids
+             *  are cut into one contiguous slice per thread and the slice winners are reduced in id order, so ties
+             *  always go to the lowest id.
+             */
+            int num_slices = this->num_threads;
+            slices.resize(num_slices);
+            std::atomic<uint64_t> spent = 0;
+            this->run_tasks(num_slices, [&](int s)
+                            {
+                uint32_t begin = uint32_t((uint64_t(this->n) * s) / num_slices);
+                uint32_t end = uint32_t((uint64_t(this->n) * (s + 1)) / num_slices);
+                this->scan_slice(slices[s], begin, end, spent); });
+
+            bool complete = true;
+            for (auto &slice : slices)
+            {
+                this->run_stats.add_counts(slice.counts);
+                complete = !this->abandoned(slice.stopped) && complete;
+                if (this->is_better(slice.best_marginal_val, slice.best_marginal_cost, best_marginal_val, best_marginal_cost))
+                {
+                    best_id = slice.best_id;
+                    best_marginal_val = slice.best_marginal_val;
+                    best_marginal_cost = slice.best_marginal_cost;
+                }
+            }
+            return complete;
+        }
+
+        void scan_slice(Slice &slice, uint32_t begin, uint32_t end, std::atomic<uint64_t> &spent)
+        {
+            slice.batch_ids.resize(this->BATCH_SIZE);
+            slice.batch_gains.resize(this->BATCH_SIZE);
+            slice.batch_costs.resize(this->BATCH_SIZE);
+            slice.best_id = 0;
+            slice.best_marginal_val = -DBL_MAX;
+            slice.best_marginal_cost = 1;
+            slice.counts.clear();
+            slice.stopped = stopping::StopReason::NONE;
+            uint32_t block_size = 0;
+
+            for (uint32_t id = begin; id < end && slice.stopped == stopping::StopReason::NONE; id++)
+            {
+                // skip elements already in the set, or that would violate a constraint
+                E *el = (*this->ground_set)[id];
+                if (this->in_set.contains(id) || !this->can_add(el, slice.counts.constraint_checks))
+                {
+                    continue;
+                }
+                slice.batch_costs[block_size] = this->cost_benefit ? this->knapsack_cost(el) : 1;
+
+                // queue feasible candidates up and evaluate them a block at a time
+                slice.batch_ids[block_size] = id;
+                block_size++;
+                if (block_size == this->BATCH_SIZE)
+                {
+                    this->scan_block(slice, block_size, spent);
+                    block_size = 0;
+                }
+            }
+            this->scan_block(slice, block_size, spent);
+        }
+
+        void scan_block(Slice &slice, uint32_t block_size, std::atomic<uint64_t> &spent)
+        {
+            // evaluate the queued candidates in one batch, keeping running track of the best one
+            if (block_size == 0 || slice.stopped != stopping::StopReason::NONE || !this->spend(spent, block_size, slice.stopped))
+            {
+                return;
+            }
+            dispatch::gains(*this->cost_function, this->oracle_state.get(), slice.batch_ids.data(), block_size, slice.batch_gains.data());
+            slice.counts.oracle_evaluations = slice.counts.oracle_evaluations + block_size;
+            for (uint32_t i = 0; i < block_size; i++)
+            {
+                if (this->is_better(slice.batch_gains[i], slice.batch_costs[i], slice.best_marginal_val, slice.best_marginal_cost))
+                {
+                    slice.best_id = slice.batch_ids[i];
+                    slice.best_marginal_val = slice.batch_gains[i];
+                    slice.best_marginal_cost = slice.batch_costs[i];
+                }
+            }
+        }
+
+        bool is_better(double val, double cost, double best_val, double best_cost) const
+        {
+            // strictly better only, so the earliest (lowest id) of equally good candidates wins
+            if (this->cost_benefit)
+            {
+                return val / cost > best_val / best_cost;
+            }
+            return val > best_val;
+        }
+    };
+
+    template <typename E, typename Cost, typename... Constraints>
+    class LazyGreedy : public GreedyCore<E, Cost, Constraints...>
+    {
+        // the lazy greedy algorithm, keeping upper bounds on the marginals (or ratios) in a priority queue
+    public:
+        using GreedyCore<E, Cost, Constraints...>::GreedyCore;
+
+        void set_reevaluation_batch(uint32_t batch)
+        {
+            /* Pop up to batch stale entries off the queue at a time and re-evaluate them together (in parallel,
+             *  given threads). This can spend a few extra oracle calls per iteration, but since ties go to the
+             *  lowest id the selected element is always the one the one-at-a-time lazy greedy selects.
+             */
+            this->reevaluation_batch = std::max(uint32_t(1), batch);
+        }
+
+        void clear_set()
+        {
+            // also forgets the queue and which elements were dropped
+            GreedyCore<E, Cost, Constraints...>::clear_set();
+            this->clear_marginals();
+            this->index_partitions();
+        }
+
+        void run_greedy()
+        {
+            if (!this->is_configured())
+            {
+                return;
+            }
+            this->clear_set(); // fresh oracle state and marginals
+            this->run_stats.clear();
+            this->stopping_policy.start();
+            const char *name = this->cost_benefit ? "CostBenefitLazyGreedy" : "LazyGreedy";
+            int counter = 0;
+            while (!this->constraint_saturated && !this->stopping_policy.reached(this->run_stats, this->curr_set.size(), this->curr_val))
+            {
+                counter++;
+                telemetry::IterationTimer timer;
+                double prev_val = this->curr_val;
+                if (counter == 1)
+                {
+                    first_iteration(); // initializes marginals in first greedy iteration
+                }
+                else
+                {
+                    lazy_greedy_step();
+                }
+                if (this->stop_reason() != stopping::StopReason::NONE)
+                {
+                    break; // abandoned midway, nothing was added
+                }
+                timer.record(this->run_stats, this->curr_val - prev_val);
+                this->trace_iteration(name, counter);
+            }
+            this->tracer.run(name, this->run_stats, this->curr_set.size(), this->curr_val);
+        }
+
+    private:
+        heap::LazyHeap marginals;        // (upper bounds on) marginals, or ratios, by id, stamped with the iteration computed in
+        uint32_t iteration = 0;          // current greedy iteration
+        std::vector<double> costs;       // cost-benefit only: marginal knapsack cost by id
+        uint32_t reevaluation_batch = 1; // stale queue entries re-evaluated together
+        std::vector<uint32_t> stale_ids; // entries popped for re-evaluation
+        std::vector<double> stale_gains; // their fresh marginals
+
+        struct Slice
+        {
+            // scratch space of one contiguous range of ids scanned by one thread in the first iteration
+            std::vector<uint32_t> batch_ids;                  // feasible candidates waiting for evaluation
+            std::vector<double> batch_gains;                  // their marginal gains
+            std::vector<std::pair<uint32_t, double>> entries;          // evaluated candidates, to be heapified
+            telemetry::OptimizerStats counts;                          // this slice's share of the counters
+            stopping::StopReason stopped = stopping::StopReason::NONE; // set if a hard limit cut the slice short
+        };
+        std::vector<Slice> slices;
+
+        struct PartitionIndex
+        {
+            // a partition matroid among the constraints, with the ids of each of its parts not dropped yet
+            constraint::PartitionMatroid<E> *matroid;
+            constraint::ConstraintState<E> *state;
+            std::vector<std::vector<uint32_t>> ids;
+        };
+        std::vector<PartitionIndex> partitions;
+        groundset::Membership dropped;    // ids in full parts, discarded unchecked when they reach the top of the queue
+        std::size_t dropped_in_queue = 0; // (at most) how many queue entries are dropped
+
+        double score(const uint32_t &id, const double &gain) const
+        {
+            return this->cost_benefit ? gain / costs[id] : gain;
+        }
+
+        void first_iteration()
+        {
+            // evaluate every feasible singleton, one contiguous slice of ids per thread
+            int num_slices = this->num_threads;
+            slices.resize(num_slices);
+            std::atomic<uint64_t> spent = 0;
+            this->run_tasks(num_slices, [&](int s)
+                            {
+                uint32_t begin = uint32_t((uint64_t(this->n) * s) / num_slices);
+                uint32_t end = uint32_t((uint64_t(this->n) * (s + 1)) / num_slices);
+                this->scan_slice(slices[s], begin, end, spent); });
+
+            // then build the priority queue in one go instead of n pushes
+            marginals.clear();
+            bool complete = true;
+            for (auto &slice : slices)
+            {
+                for (auto &[id, gain] : slice.entries)
+                {
+                    marginals.append(id, score(id, gain), iteration);
+                }
+                this->run_stats.add_counts(slice.counts);
+                complete = !this->abandoned(slice.stopped) && complete;
+            }
+            if (!complete)
+            {
+                return; // a hard limit was hit, the step is abandoned
+            }
+            marginals.heapify();
+            this->run_stats.queue_pushes = this->run_stats.queue_pushes + marginals.size();
+
+            this->select_top();
+        }
+
+        void scan_slice(Slice &slice, uint32_t begin, uint32_t end, std::atomic<uint64_t> &spent)
+        {
+            slice.batch_ids.resize(this->BATCH_SIZE);
+            slice.batch_gains.resize(this->BATCH_SIZE);
+            slice.entries.clear();
+            slice.counts.clear();
+            slice.stopped = stopping::StopReason::NONE;
+            uint32_t block_size = 0;
+
+            for (uint32_t id = begin; id <= end; id++)
+            {
+                // evaluate the queued candidates a block at a time (and whatever is left at the end)
+                if (block_size == this->BATCH_SIZE || (id == end && block_size > 0))
+                {
+                    if (!this->spend(spent, block_size, slice.stopped))
+                    {
+                        return;
+                    }
+                    dispatch::gains(*this->cost_function, this->oracle_state.get(), slice.batch_ids.data(), block_size, slice.batch_gains.data());
+                    slice.counts.oracle_evaluations = slice.counts.oracle_evaluations + block_size;
+                    for (uint32_t i = 0; i < block_size; i++)
+                    {
+                        slice.entries.push_back({slice.batch_ids[i], slice.batch_gains[i]});
+                    }
+                    block_size = 0;
+                }
+
+                // check if element in set yet, and if test set violates constraint, skip it
+                if (id == end || this->in_set.contains(id) || !this->can_add((*this->ground_set)[id], slice.counts.constraint_checks))
+                {
+                    continue;
+                }
+                if (this->cost_benefit)
+                {
+                    costs[id] = this->knapsack_cost((*this->ground_set)[id]); // every id is in one slice only
+                }
+
+                slice.batch_ids[block_size] = id;
+                block_size++;
+            }
+        }
+
+        void lazy_greedy_step()
+        {
+            iteration++;
+            this->compact_marginals();
+
+            // until the top of the queue has been evaluated this iteration, its score is only an upper bound
+            while (!marginals.empty() && marginals.top_stamp() != iteration)
+            {
+                if (reevaluation_batch == 1)
+                {
+                    // one at a time, the top entry is re-evaluated and sifted down in place
+                    uint32_t id = marginals.top_id();
+                    if (this->pop_dropped(id) || !this->can_add((*this->ground_set)[id], this->run_stats.constraint_checks))
+                    {
+                        marginals.pop();
+                        this->run_stats.queue_pops++;
+                        continue; // leave element out from now on
+                    }
+                    if (this->stopping_policy.interrupt(this->run_stats.oracle_evaluations + 1))
+                    {
+                        return;
+                    }
+                    double gain;
+                    dispatch::gains(*this->cost_function, this->oracle_state.get(), &id, 1, &gain);
+                    marginals.update_top(score(id, gain), iteration);
+                    this->run_stats.oracle_evaluations++;
+                    this->run_stats.reevaluations++;
+                    this->run_stats.queue_updates++;
+                    continue;
+                }
+
+                // pull up to reevaluation_batch stale elements from priority queue
+                stale_ids.clear();
+                while (!marginals.empty() && stale_ids.size() < reevaluation_batch && marginals.top_stamp() != iteration)
+                {
+                    uint32_t id = marginals.top_id();
+                    marginals.pop();
+                    this->run_stats.queue_pops++;
+                    if (this->pop_dropped(id) || !this->can_add((*this->ground_set)[id], this->run_stats.constraint_checks))
+                    {
+                        continue; // leave element out from now on
+                    }
+                    stale_ids.push_back(id);
+                }
+
+                // put updated candidates back into priority queue
+                if (this->stopping_policy.interrupt(this->run_stats.oracle_evaluations + stale_ids.size()))
+                {
+                    return;
+                }
+                this->reevaluate_stale();
+                this->run_stats.oracle_evaluations = this->run_stats.oracle_evaluations + stale_ids.size();
+                this->run_stats.reevaluations = this->run_stats.reevaluations + stale_ids.size();
+                this->run_stats.queue_pushes = this->run_stats.queue_pushes + stale_ids.size();
+                for (std::size_t i = 0; i < stale_ids.size(); i++)
+                {
+                    marginals.push(stale_ids[i], score(stale_ids[i], stale_gains[i]), iteration);
+                }
+            }
+
+            this->select_top();
+        }
+
+        void reevaluate_stale()
+        {
+            // split the stale entries into one contiguous chunk per thread, each evaluated with the batch oracle
+            std::size_t count = stale_ids.size();
+            stale_gains.resize(count);
+            int num_chunks = int(std::min<std::size_t>(this->num_threads, count));
+            this->run_tasks(num_chunks, [&](int c)
+                            {
+                std::size_t begin = (count * c) / num_chunks;
+                std::size_t end = (count * (c + 1)) / num_chunks;
+                dispatch::gains(*this->cost_function, this->oracle_state.get(), stale_ids.data() + begin, end - begin, stale_gains.data() + begin); });
+        }
+
+        void select_top()
+        {
+            // adds the top of the queue if its (fresh) score is positive, otherwise no element is worth adding
+            if (!marginals.empty() && marginals.top_value() > 0)
+            {
+                uint32_t id = marginals.top_id();
+                marginals.pop();
+                this->run_stats.queue_pops++;
+                this->add_to_set(id);
+                this->drop_full_parts((*this->ground_set)[id]);
+            }
+            else
+            {
+                this->constraint_saturated = true;
+            }
+        }
+
+        void clear_marginals()
+        {
+            marginals.clear();
+            iteration = 0;
+            costs.assign(this->cost_benefit ? this->n : 0, 1);
+        }
+
+        void index_partitions()
+        {
+            // index the parts of every partition matroid, to drop whole parts once they are full
+            partitions.clear();
+            dropped.resize(this->n);
+            dropped_in_queue = 0;
+            this->for_each_constraint([&](auto *C, constraint::ConstraintState<E> *state)
+                                      {
+                constraint::PartitionMatroid<E> *M = dispatch::cast<constraint::PartitionMatroid<E>>(C);
+                if (M == nullptr || state == nullptr)
+                {
+                    return;
+                }
+                PartitionIndex index{M, state, std::vector<std::vector<uint32_t>>(M->num_parts())};
+                for (uint32_t id = 0; id < uint32_t(this->n); id++)
+                {
+                    if (uint32_t p = M->part((*this->ground_set)[id]); p != M->NO_PART)
+                    {
+                        index.ids[p].push_back(id);
+                    }
+                }
+                partitions.push_back(std::move(index)); });
+        }
+
+        void drop_full_parts(E *el)
+        {
+            // once el fills its part of a partition matroid, no other element of that part can ever be added
+            for (auto &index : partitions)
+            {
+                uint32_t p = index.matroid->part(el);
+                if (p == index.matroid->NO_PART || !index.matroid->is_full(index.state, p))
+                {
+                    continue;
+                }
+                for (auto id : index.ids[p])
+                {
+                    if (!this->in_set.contains(id) && !dropped.contains(id))
+                    {
+                        dropped.insert(id);
+                        dropped_in_queue++;
+                    }
+                }
+                index.ids[p].clear();
+            }
+        }
+
+        bool pop_dropped(const uint32_t &id)
+        {
+            // whether the entry just popped for id belongs to a full part
+            if (!dropped.contains(id))
+            {
+                return false;
+            }
+            dropped_in_queue = dropped_in_queue - (dropped_in_queue > 0);
+            return true;
+        }
+
+        void compact_marginals()
+        {
+            /* Erasing from the middle of a heap is not worth it, so dropped entries are skipped as they surface,
+             *  and once they make up half the queue it is rebuilt without them.
+             */
+            if (2 * dropped_in_queue <= marginals.size())
+            {
+                return;
+            }
+            marginals.retain([&](const uint32_t &id)
+                             { return !dropped.contains(id); });
+            dropped_in_queue = 0;
+        }
+    };
+
+    template <template <typename, typename, typename...> class Optimizer, typename E>
+    class TypeErased : public Optimizer<E, costfunction::CostFunction<E>, constraint::Intersection<E>>
+    {
+        /* Optimizer over any cost function and constraints added at run time, as VanillaGreedy<E> and
+         *  LazyGreedy<E> are. Every oracle call goes through the vtable, and the constraints in constraint_set
+         *  are gathered into one Intersection when a run starts.
+         */
+        using Base = Optimizer<E, costfunction::CostFunction<E>, constraint::Intersection<E>>;
+        constraint::Intersection<E> all_constraints; // constraint_set, in its iteration order
+
+    public:
+        std::unordered_set<constraint::Constraint<E> *> constraint_set;
+
+        TypeErased()
+        {
+            this->set_constraints(&all_constraints);
+        }
+
+        void add_constraint(constraint::Constraint<E> *C)
+        {
+            this->constraint_set.insert(C);
+        }
+
+        void remove_constraint(constraint::Constraint<E> *C)
+        {
+            this->constraint_set.erase(C);
+        }
+
+        bool check_constraints(std::unordered_set<E *> &set)
+        {
+            // whether set satisfies every constraint
+            this->gather_constraints();
+            return all_constraints.test_membership(set);
+        }
+
+        bool check_saturated(std::unordered_set<E *> &set)
+        {
+            // whether set saturates any constraint, and so their intersection
+            this->gather_constraints();
+            return all_constraints.is_saturated(set);
+        }
+
+        bool is_configured()
+        {
+            this->gather_constraints();
+            return Base::is_configured();
+        }
+
+        void clear_set()
+        {
+            this->gather_constraints();
+            Base::clear_set();
+        }
+
+        void run_greedy()
+        {
+            this->gather_constraints();
+            Base::run_greedy();
+        }
+
+    private:
+        void gather_constraints()
+        {
+            // also points the optimizer back at all_constraints, which moves along with this object
+            all_constraints.members.assign(constraint_set.begin(), constraint_set.end());
+            this->set_constraints(&all_constraints);
+        }
+    };
+}
@@ -3,34 +3,55 @@
 #include <iostream>
 #include <vector>
 #include <cfloat>
+#include <memory>
 #include "../../sfo_concepts/element.hpp"
+#include "../../sfo_concepts/ground_set.hpp"
 #include "../../sfo_concepts/cost_function.hpp"
 #include "../../sfo_concepts/constraint.hpp"
+#include "../../utils/telemetry.hpp"
+#include "../../utils/stopping.hpp"
+#include "../../utils/sampling.hpp"
 
 template <typename E>
 class StochasticGreedy
 {
 private:
     int b;
-    int MAXITER = 15;
-    std::vector<E *> ground_set_idxs; // this maps us from an integer to an element
-    std::unordered_set<E *> to_erase; // used to discard and no longer randomly sample elements
+    stopping::StoppingPolicy stopping_policy; // limits of a run, none by default
+    groundset::GroundSet<E> owned_ground_set; // backs ground_set when handed a std::unordered_set
+    groundset::Membership in_set;             // ids of the elements in curr_set
+    std::unique_ptr<costfunction::OracleState<E>> oracle_state; // incremental oracle state of curr_set
+    sampling::IdSampler sampler;           // ids of the elements we can still sample
+    sampling::Rng rng;                     // reseeded with seed at the start of every run
+    std::vector<uint32_t> sample_set;      // ids drawn this iteration, reused across iterations
+    std::vector<uint32_t> to_discard;      // ids found infeasible this iteration, never sampled again
+    telemetry::OptimizerStats run_stats;   // counters of the last run
+    telemetry::Tracer tracer;              // optional trace sink, silent without one
+    // running state of each constraint in constraint_set, so feasibility checks never look at curr_set
+    std::vector<std::pair<constraint::Constraint<E> *, std::unique_ptr<constraint::ConstraintState<E>>>> constraint_states;
 
 public:
     double curr_val = 0; // current value of elements in set
     bool constraint_saturated = false;
-    std::unordered_set<E *> *ground_set;
-    int n = 0; // holds size of ground set, indexed from 0 to n-1
+    groundset::GroundSet<E> *ground_set = nullptr; // pointer to dense, id-indexed ground set of elements
+    int n = 0;                                     // holds size of ground set, indexed from 0 to n-1
     std::unordered_set<constraint::Constraint<E> *> constraint_set;
-    costfunction::CostFunction<E> *cost_function;
+    costfunction::CostFunction<E> *cost_function = nullptr;
     std::unordered_set<E *> curr_set; // will hold elements selected to be in our set
     double epsilon = 0;
+    uint64_t seed = sampling::DEFAULT_SEED; // runs with the same seed draw the same samples
 
-    void set_ground_set(std::unordered_set<E *> *V)
+    void set_ground_set(groundset::GroundSet<E> *V)
     {
         this->ground_set = V;
         this->n = V->size();
-        this->index_ground_set();
+    }
+
+    void set_ground_set(std::unordered_set<E *> *V)
+    {
+        // number the elements once, then work on the dense ground set
+        this->owned_ground_set = groundset::GroundSet<E>(*V);
+        this->set_ground_set(&(this->owned_ground_set));
     }
 
     void add_constraint(constraint::Constraint<E> *C)
@@ -50,10 +71,11 @@ public:
         this->constraint_set.erase(C);
     }
 
-    bool check_constraints(std::unordered_set<E *> set)
+    bool check_constraints(std::unordered_set<E *> &set)
     {
         for (auto iter = constraint_set.begin(); iter != constraint_set.end(); ++iter)
         {
+            run_stats.constraint_checks++;
             if (!((*iter)->test_membership(set)))
             {
                 // if any constraint is not satisfied, then intersection of them is not
@@ -63,7 +85,7 @@ public:
         return true; // if all constraints were satisfied, then return true
     }
 
-    bool check_saturated(std::unordered_set<E *> set)
+    bool check_saturated(std::unordered_set<E *> &set)
     {
         for (auto iter = constraint_set.begin(); iter != constraint_set.end(); ++iter)
         {
@@ -86,10 +108,44 @@ public:
         this->epsilon = epsilon;
     }
 
+    void set_seed(uint64_t seed)
+    {
+        this->seed = seed;
+    }
+
+    const telemetry::OptimizerStats &stats() const
+    {
+        return this->run_stats;
+    }
+
+    void set_trace_sink(telemetry::TraceSink *sink)
+    {
+        // per-iteration events (and, at TraceLevel::DEBUG, the current set) go to sink; nullptr silences them
+        this->tracer.sink = sink;
+    }
+
+    void set_stopping_policy(const stopping::StoppingPolicy &policy)
+    {
+        // a run stops at the first of its limits, or when no element can be added
+        this->stopping_policy = policy;
+    }
+
+    stopping::StopReason stop_reason() const
+    {
+        return this->stopping_policy.reason;
+    }
+
     void clear_set()
     {
         this->curr_set.clear();
+        this->in_set.resize(this->n);
+        this->reset_constraint_states();
         this->curr_val = 0;
+        if (this->cost_function)
+        {
+            this->oracle_state = this->cost_function->new_state(this->ground_set);
+            this->curr_val = this->oracle_state->value;
+        }
         this->constraint_saturated = false;
     }
 
@@ -128,21 +184,34 @@ public:
             // stochastic greedy is only valid for cardinality constraints, so check
             constraint::Cardinality<E> *k = find_single_cardinality();
             this->b = k->budget;
-            this->curr_val = 0;
+            this->clear_set();
+            this->run_stats.clear();
+            this->stopping_policy.start();
+            this->sampler.reset(this->n);
+            this->rng.seed(this->seed);
             // first, compute how many samples to randomly pull at each step
-            int sample_size = compute_random_set_size();
-            std::unordered_set<E *> *sample_set = new std::unordered_set<E *>;
+            uint32_t sample_size = compute_random_set_size();
             int counter = 0;
-            while (!constraint_saturated && counter < MAXITER)
+            while (!constraint_saturated && !stopping_policy.reached(run_stats, curr_set.size(), curr_val))
             {
                 counter++;
-                *sample_set = sample_ground_set(sample_size);
-                std::cout << "Sampled set: " << *sample_set << std::endl;
+                telemetry::IterationTimer timer;
+                double prev_val = curr_val;
+                sampler.draw(sample_size, rng, sample_set);
+                run_stats.samples_drawn = run_stats.samples_drawn + sample_set.size();
+                tracer.debug([&](auto &os)
+                             {
+                                 os << "Sampled set: ";
+                                 this->print_sample(sample_set, os); });
                 stochastic_greedy_step(sample_set);
-                sample_size = std::min(sample_size, int(ground_set_idxs.size()));
-                std::cout << "Performed greedy algorithm iteration: " << counter << std::endl;
-                print_status();
+                if (stopping_policy.reason != stopping::StopReason::NONE)
+                {
+                    break; // abandoned midway, nothing was added
+                }
+                timer.record(run_stats, curr_val - prev_val);
+                trace_iteration("StochasticGreedy", counter);
             }
+            tracer.run("StochasticGreedy", run_stats, curr_set.size(), curr_val);
         }
         else
         {
@@ -150,105 +219,79 @@ public:
         }
     };
 
-    void print_status()
+    void print_status(std::ostream &os = std::cout)
     {
-        std::cout << "Current set:";
-        std::cout << curr_set;
-        std::cout << "Current val: " << curr_val << std::endl;
-        std::cout << "Constraint saturated? " << constraint_saturated << std::endl;
+        os << "Current set:";
+        os << curr_set;
+        os << "Current val: " << curr_val << std::endl;
+        os << "Constraint saturated? " << constraint_saturated << std::endl;
     };
 
 private:
-    int compute_random_set_size()
+    void trace_iteration(const char *optimizer, const int &counter)
     {
-        return int(std::min((double(this->n) / this->b) * log(1.0 / this->epsilon), double(this->n)));
+        tracer.iteration(optimizer, counter, run_stats, curr_set.size(), curr_val, constraint_saturated);
+        tracer.debug([&](auto &os)
+                     { this->print_status(os); });
     }
 
-    void index_ground_set()
+    uint32_t compute_random_set_size()
     {
-        int idx = 0;
-        for (auto el = ground_set->begin(); el != ground_set->end(); ++el, ++idx)
-        {
-            ground_set_idxs.push_back(*el);
-        }
+        // at least one sample, even when the budget is large enough for the formula to round down to zero
+        return std::max(1u, uint32_t(std::min((double(this->n) / this->b) * log(1.0 / this->epsilon), double(this->n))));
     }
 
-    std::unordered_set<E *> sample_ground_set(int &set_size)
+    void print_sample(std::vector<uint32_t> &sample_set, std::ostream &os)
     {
-        std::unordered_set<E *> random_set;
-        E *candidate;
-        int rand_idx;
-        int count = 0;
-        // main sampling loop
-        while (count < set_size)
+        os << "{";
+        for (auto id : sample_set)
         {
-            rand_idx = rand() % ground_set_idxs.size(); // pull a random index between 0 and n
-            candidate = ground_set_idxs[rand_idx];      // find which element pointer it corresponds to
-
-            // first, check if it is no longer feasible and toss it if so
-            if (to_erase.find(candidate) != to_erase.end())
-            {
-                ground_set_idxs.erase(ground_set_idxs.begin() + rand_idx);
-                to_erase.erase(candidate);
-            }
-            else
-            {
-                // then see if we haven't added it to the set already
-                if (random_set.find(candidate) == random_set.end())
-                {
-                    random_set.insert(ground_set_idxs[rand_idx]);
-                    count++; // increment number of elements in our set
-                }
-                else
-                {
-                    continue;
-                }
-            }
+            os << *(*ground_set)[id] << ",";
         }
-        return random_set;
+        os << "}";
     }
 
-    void stochastic_greedy_step(std::unordered_set<E *> *sampled_set)
+    void stochastic_greedy_step(std::vector<uint32_t> &sampled_set)
     {
-        std::unordered_set<E *> test_set(curr_set);
-        E *best_el;
+        uint32_t best_id = 0;
         double best_marginal_val = -DBL_MAX;
         double candidate_marginal_val = 0;
 
-        // randomly sample a set of size sample_size
-        // compute the marginal gains for the elements in that set
-        // choose the max gain element from the set
-
-        for (auto el = sampled_set->begin(); el != sampled_set->end(); ++el)
+        // compute the marginal gains for the elements in the sample
+        // choose the max gain element from the sample
+        to_discard.clear();
+        for (auto id : sampled_set)
         {
-            // note that el is a POINTER to a POINTER to an element in the ground set
-            test_set = curr_set;
-
-            if (curr_set.find(*el) != curr_set.end())
+            E *el = (*ground_set)[id];
+            if (!this->can_add(el, run_stats.constraint_checks))
             {
+                // the element is not to be considered or sampled again
+                to_discard.push_back(id);
                 continue;
             }
 
-            test_set.insert(*el);
-
-            if (!this->check_constraints(test_set))
+            if (stopping_policy.interrupt(run_stats.oracle_evaluations + 1))
             {
-                // mark the element to not be considered or sampled
-                this->to_erase.insert(*el);
-                continue;
+                return; // a hard limit was hit, the step is abandoned
             }
 
             // update marginal value
-            candidate_marginal_val = cost_function->evaluate(test_set) - curr_val;
+            candidate_marginal_val = cost_function->gain(oracle_state.get(), el);
+            run_stats.oracle_evaluations++;
 
             // keep running track of highest marginal value element
             if (candidate_marginal_val > best_marginal_val)
             {
-                best_el = *el;
+                best_id = id;
                 best_marginal_val = candidate_marginal_val;
             }
         }
 
+        for (auto id : to_discard)
+        {
+            sampler.discard(id);
+        }
+
         // check if we could even add an element to set
         if (best_marginal_val < 0)
         {
@@ -257,12 +300,55 @@ private:
         else
         {
             // update the current set, value, and budget value with the found item
-            curr_set.insert(best_el);
-            curr_val = curr_val + best_marginal_val;
-            constraint_saturated = this->check_saturated(curr_set); // check if constraint is now saturated
+            this->add_to_set(best_id);
         }
     };
 
+    void reset_constraint_states()
+    {
+        constraint_states.clear();
+        for (auto C : constraint_set)
+        {
+            constraint_states.push_back({C, C->new_state()});
+        }
+    }
+
+    bool can_add(E *el, uint64_t &checks)
+    {
+        // checks el against every constraint's running state, counting the checks
+        for (auto &[C, state] : constraint_states)
+        {
+            checks++;
+            if (!C->can_add(state.get(), el))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void commit_constraints(E *el)
+    {
+        // updates every constraint's running state, and whether any of them is now saturated
+        constraint_saturated = false;
+        for (auto &[C, state] : constraint_states)
+        {
+            C->commit(state.get(), el);
+            constraint_saturated = constraint_saturated || C->saturated(state.get());
+        }
+    }
+
+    void add_to_set(uint32_t id)
+    {
+        E *el = (*ground_set)[id];
+        curr_set.insert(el);
+        in_set.insert(id);
+        sampler.discard(id); // selected elements are no longer candidates
+        cost_function->commit(oracle_state.get(), el);
+        curr_val = oracle_state->value;
+        this->commit_constraints(el); // allows for early stop detection
+    }
+
     constraint::Cardinality<E> *find_single_cardinality()
     {
         constraint::Cardinality<E> *cardinality_ptr;
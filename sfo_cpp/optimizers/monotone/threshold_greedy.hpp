@@ -0,0 +1,414 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+#include <cfloat>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "../../sfo_concepts/element.hpp"
+#include "../../sfo_concepts/ground_set.hpp"
+#include "../../sfo_concepts/cost_function.hpp"
+#include "../../sfo_concepts/constraint.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/telemetry.hpp"
+#include "../../utils/stopping.hpp"
+
+template <typename E>
+class ThresholdGreedy
+{
+    /* Decreasing-threshold greedy (Badanidiyuru and Vondrak, 2014). Starting from the largest singleton value d,
+     *  each pass walks over the remaining elements in id order and adds every feasible one whose marginal is at
+     *  least the threshold w, then lowers w by a factor (1 - epsilon), until w drops below epsilon * d / n.
+     *  That is O((n / epsilon) log(n / epsilon)) marginals whatever the budget, for a (1 - 1/e - epsilon)
+     *  guarantee under a cardinality constraint.
+     *
+     *  Every element keeps the last marginal computed for it, an upper bound on its marginal from then on,
+     *  so elements below the threshold are skipped without an oracle call.
+     */
+private:
+    stopping::StoppingPolicy stopping_policy; // limits of a run, none by default
+    groundset::GroundSet<E> owned_ground_set; // backs ground_set when handed a std::unordered_set
+    groundset::Membership in_set;             // ids of the elements in curr_set
+    std::vector<uint32_t> remaining;          // ids that may still be added, in increasing order
+    std::vector<double> bounds;               // last computed marginal of each id
+    std::vector<uint32_t> evaluated_at;       // size of curr_set when each id's bound was computed
+    std::vector<uint32_t> block_ids;          // candidates of the current block, at or above the threshold
+    std::vector<uint32_t> stale_ids;          // those of them whose bound is out of date
+    std::vector<double> stale_gains;          // their fresh marginals
+    std::unique_ptr<costfunction::OracleState<E>> oracle_state; // incremental oracle state of curr_set
+    uint32_t BATCH_SIZE = 256;                                  // candidates handed to the batch oracle at once
+    int num_threads = 1;                                        // threads evaluating each block of a pass
+    std::unique_ptr<parallel::WorkerPool> pool;                 // only started when num_threads > 1
+    telemetry::OptimizerStats run_stats;                        // counters of the last run
+    telemetry::Tracer tracer;                                   // optional trace sink, silent without one
+    // running state of each constraint in constraint_set, so feasibility checks never look at curr_set
+    std::vector<std::pair<constraint::Constraint<E> *, std::unique_ptr<constraint::ConstraintState<E>>>> constraint_states;
+    bool stopped = false; // the stopping policy ended the run in the middle of a pass
+
+public:
+    double curr_val = 0; // current value of elements in set
+    bool constraint_saturated = false;
+    groundset::GroundSet<E> *ground_set = nullptr; // pointer to dense, id-indexed ground set of elements
+    int n = 0;                                     // holds size of ground set, indexed from 0 to n-1
+    std::unordered_set<constraint::Constraint<E> *> constraint_set;
+    costfunction::CostFunction<E> *cost_function;
+    double epsilon = 0.1;              // threshold decay, and how far below the largest singleton the passes go
+    double threshold = 0;              // threshold of the last pass
+    std::unordered_set<E *> curr_set; // will hold elements selected to be in our set
+
+    void set_ground_set(groundset::GroundSet<E> *V)
+    {
+        this->ground_set = V;
+        this->n = V->size();
+    }
+
+    void set_ground_set(std::unordered_set<E *> *V)
+    {
+        // number the elements once, then work on the dense ground set
+        this->owned_ground_set = groundset::GroundSet<E>(*V);
+        this->set_ground_set(&(this->owned_ground_set));
+    }
+
+    void add_constraint(constraint::Constraint<E> *C)
+    {
+        this->constraint_set.insert(C);
+    }
+
+    void remove_constraint(constraint::Constraint<E> *C)
+    {
+        this->constraint_set.erase(C);
+    }
+
+    bool check_constraints(std::unordered_set<E *> &set)
+    {
+        for (auto iter = constraint_set.begin(); iter != constraint_set.end(); ++iter)
+        {
+            if (!((*iter)->test_membership(set)))
+            {
+                // if any constraint is not satisfied, then intersection of them is not
+                return false;
+            }
+        }
+        return true; // if all constraints were satisfied, then return true
+    }
+
+    bool check_saturated(std::unordered_set<E *> &set)
+    {
+        for (auto iter = constraint_set.begin(); iter != constraint_set.end(); ++iter)
+        {
+            if ((*iter)->is_saturated(set))
+            {
+                // if any constraint is saturated, then so is intersection
+                return true;
+            }
+        }
+        return false; // if no constraints were saturated, then return true
+    }
+
+    void set_cost_function(costfunction::CostFunction<E> *F)
+    {
+        this->cost_function = F;
+    }
+
+    void set_epsilon(double epsilon)
+    {
+        this->epsilon = epsilon;
+    }
+
+    void set_num_threads(int threads)
+    {
+        /* Evaluate each block of a pass on several threads. Elements are still accepted one at a time in id
+         *  order, re-evaluating any whose marginal went stale within the block, so the result does not depend
+         *  on the thread count. The cost function's gains and the constraints must be safe to call concurrently.
+         */
+        this->num_threads = std::max(1, threads);
+        this->pool.reset(this->num_threads > 1 ? new parallel::WorkerPool(this->num_threads) : nullptr);
+    }
+
+    const telemetry::OptimizerStats &stats() const
+    {
+        return this->run_stats;
+    }
+
+    void set_trace_sink(telemetry::TraceSink *sink)
+    {
+        // per-pass events (and, at TraceLevel::DEBUG, the current set) go to sink; nullptr silences them
+        this->tracer.sink = sink;
+    }
+
+    void set_stopping_policy(const stopping::StoppingPolicy &policy)
+    {
+        /* A run stops at the first of its limits, or when no element can be added. Each pass is one
+         *  iteration, but the element, evaluation and time limits are also checked before every addition.
+         */
+        this->stopping_policy = policy;
+    }
+
+    stopping::StopReason stop_reason() const
+    {
+        return this->stopping_policy.reason;
+    }
+
+    void clear_set()
+    {
+        this->curr_set.clear();
+        this->in_set.resize(this->n);
+        this->remaining.clear();
+        this->bounds.assign(this->n, 0);
+        this->evaluated_at.assign(this->n, 0);
+        if (this->cost_function)
+        {
+            this->oracle_state = this->cost_function->new_state(this->ground_set);
+            this->curr_val = this->oracle_state->value;
+        }
+        else
+        {
+            this->oracle_state.reset();
+            this->curr_val = 0;
+        }
+        this->constraint_saturated = false;
+        this->stopped = false;
+        this->threshold = 0;
+        this->reset_constraint_states();
+    }
+
+    bool is_configured()
+    {
+        if (!this->ground_set)
+        {
+            std::cout << "No ground set given!" << std::endl;
+            return false;
+        }
+        else if (!this->cost_function)
+        {
+            std::cout << "No cost function given!" << std::endl;
+            return false;
+        }
+        else if (!(this->epsilon > 0 && this->epsilon < 1))
+        {
+            std::cout << "Threshold greedy needs 0 < epsilon < 1!" << std::endl;
+            return false;
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    void run_greedy()
+    {
+        if (this->is_configured())
+        {
+            this->clear_set();
+            this->run_stats.clear();
+            this->stopping_policy.start();
+
+            // the largest singleton value sets the first threshold, and how low the thresholds go
+            double largest = this->evaluate_singletons();
+            threshold = largest;
+            double lowest = epsilon * largest / std::max(1, n);
+
+            int counter = 0;
+            while (!constraint_saturated && !stopped && !remaining.empty() && threshold > 0 && threshold >= lowest &&
+                   !stopping_policy.reached(run_stats, curr_set.size(), curr_val))
+            {
+                counter++;
+                telemetry::IterationTimer timer;
+                double prev_val = curr_val;
+                threshold_pass();
+                timer.record(run_stats, curr_val - prev_val);
+                trace_iteration("ThresholdGreedy", counter);
+                threshold = threshold * (1 - epsilon);
+            }
+            tracer.run("ThresholdGreedy", run_stats, curr_set.size(), curr_val);
+        }
+    };
+
+    void print_status(std::ostream &os = std::cout)
+    {
+        os << "Current set:";
+        os << curr_set;
+        os << "Current val: " << curr_val << std::endl;
+        os << "Current threshold: " << threshold << std::endl;
+        os << "Constraint saturated? " << constraint_saturated << std::endl;
+    };
+
+private:
+    void trace_iteration(const char *optimizer, const int &counter)
+    {
+        tracer.iteration(optimizer, counter, run_stats, curr_set.size(), curr_val, constraint_saturated);
+        tracer.debug([&](auto &os)
+                     { this->print_status(os); });
+    }
+
+    double evaluate_singletons()
+    {
+        // every feasible element's marginal on the empty set, returning the largest of them
+        for (uint32_t id = 0; id < uint32_t(n); id++)
+        {
+            if (this->can_add((*ground_set)[id], run_stats.constraint_checks))
+            {
+                remaining.push_back(id);
+            }
+        }
+        stale_ids = remaining;
+        this->evaluate_stale();
+
+        double largest = 0;
+        for (std::size_t i = 0; i < stale_ids.size(); i++)
+        {
+            bounds[stale_ids[i]] = stale_gains[i];
+            largest = std::max(largest, stale_gains[i]);
+        }
+        return largest;
+    }
+
+    void threshold_pass()
+    {
+        /* Adds, in id order, every feasible element whose marginal is at least the threshold. Candidates are
+         *  gathered a block at a time and their stale bounds evaluated together against the set at the start of
+         *  the block. Once an element of the block is added the other bounds are stale again, and by
+         *  submodularity still upper bounds, so only those still at or above the threshold are re-evaluated
+         *  before they are accepted. Elements that are infeasible or can never gain anything are dropped.
+         */
+        std::size_t block_capacity = std::size_t(BATCH_SIZE) * num_threads;
+        std::size_t kept = 0;
+        std::size_t next = 0;
+        while (next < remaining.size() && !constraint_saturated && !stopped)
+        {
+            block_ids.clear();
+            stale_ids.clear();
+            for (; next < remaining.size() && block_ids.size() < block_capacity; next++)
+            {
+                uint32_t id = remaining[next];
+                if (in_set.contains(id) || bounds[id] <= 0 || !this->can_add((*ground_set)[id], run_stats.constraint_checks))
+                {
+                    continue; // leave element out from now on
+                }
+                remaining[kept++] = id;
+                if (bounds[id] >= threshold)
+                {
+                    block_ids.push_back(id);
+                    if (evaluated_at[id] != curr_set.size())
+                    {
+                        stale_ids.push_back(id);
+                    }
+                }
+            }
+            this->evaluate_stale();
+            for (std::size_t i = 0; i < stale_ids.size(); i++)
+            {
+                bounds[stale_ids[i]] = stale_gains[i];
+                evaluated_at[stale_ids[i]] = uint32_t(curr_set.size());
+            }
+
+            for (auto id : block_ids)
+            {
+                if (constraint_saturated || bounds[id] < threshold)
+                {
+                    continue;
+                }
+                if (evaluated_at[id] != curr_set.size())
+                {
+                    // went stale after an addition earlier in this block
+                    cost_function->gains(oracle_state.get(), &id, 1, &bounds[id]);
+                    evaluated_at[id] = uint32_t(curr_set.size());
+                    run_stats.oracle_evaluations++;
+                    run_stats.reevaluations++;
+                    if (bounds[id] < threshold)
+                    {
+                        continue;
+                    }
+                }
+                if (!this->can_add((*ground_set)[id], run_stats.constraint_checks))
+                {
+                    continue;
+                }
+                if (stopping_policy.reached(run_stats, curr_set.size(), curr_val))
+                {
+                    stopped = true;
+                    break;
+                }
+                this->add_to_set(id);
+            }
+        }
+
+        // keep whatever the pass did not get to
+        remaining.erase(std::copy(remaining.begin() + next, remaining.end(), remaining.begin() + kept), remaining.end());
+    }
+
+    void evaluate_stale()
+    {
+        // split the stale ids into one contiguous chunk per thread, each evaluated with the batch oracle
+        std::size_t count = stale_ids.size();
+        stale_gains.resize(count);
+        int num_chunks = int(std::min<std::size_t>(this->num_threads, count));
+        this->run_tasks(num_chunks, [&](int c)
+                        {
+            std::size_t begin = (count * c) / num_chunks;
+            std::size_t end = (count * (c + 1)) / num_chunks;
+            cost_function->gains(oracle_state.get(), stale_ids.data() + begin, end - begin, stale_gains.data() + begin); });
+        run_stats.oracle_evaluations = run_stats.oracle_evaluations + count;
+    }
+
+    void run_tasks(int num_tasks, const std::function<void(int)> &fn)
+    {
+        if (pool)
+        {
+            pool->run(num_tasks, fn);
+        }
+        else
+        {
+            for (int i = 0; i < num_tasks; i++)
+            {
+                fn(i);
+            }
+        }
+    }
+
+    void reset_constraint_states()
+    {
+        constraint_states.clear();
+        for (auto C : constraint_set)
+        {
+            constraint_states.push_back({C, C->new_state()});
+        }
+    }
+
+    bool can_add(E *el, uint64_t &checks)
+    {
+        // checks el against every constraint's running state, counting the checks
+        for (auto &[C, state] : constraint_states)
+        {
+            checks++;
+            if (!C->can_add(state.get(), el))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void commit_constraints(E *el)
+    {
+        // updates every constraint's running state, and whether any of them is now saturated
+        constraint_saturated = false;
+        for (auto &[C, state] : constraint_states)
+        {
+            C->commit(state.get(), el);
+            constraint_saturated = constraint_saturated || C->saturated(state.get());
+        }
+    }
+
+    void add_to_set(uint32_t id)
+    {
+        E *el = (*ground_set)[id];
+        curr_set.insert(el);
+        in_set.insert(id);
+        cost_function->commit(oracle_state.get(), el);
+        curr_val = oracle_state->value;
+        this->commit_constraints(el); // check if constraint is now saturated
+    }
+};
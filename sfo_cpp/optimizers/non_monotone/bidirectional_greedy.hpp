@@ -3,33 +3,48 @@
 #include <unordered_set>
 #include <cfloat>
 #include <random>
+#include <memory>
 #include "../../sfo_concepts/element.hpp"
+#include "../../sfo_concepts/ground_set.hpp"
 #include "../../sfo_concepts/cost_function.hpp"
 #include "../../sfo_concepts/constraint.hpp"
+#include "../../utils/telemetry.hpp"
+#include "../../utils/stopping.hpp"
 
 template <typename E>
 class BidirectionalGreedy
 {
 private:
-    int MAXITER = 15;
+    stopping::StoppingPolicy stopping_policy; // limits of a run, none by default
+    groundset::GroundSet<E> owned_ground_set; // backs ground_set when handed a std::unordered_set
     bool randomized = false;
     std::unordered_set<E *> top_set;
     double top_val = 0;
     std::unordered_set<E *> bottom_set; // will hold elements selected to be in our set
     double bottom_val = 0;
+    std::unique_ptr<costfunction::OracleState<E>> bottom_state; // incremental oracle state of bottom_set
+    telemetry::OptimizerStats run_stats;                        // counters of the last run
+    telemetry::Tracer tracer;                                   // optional trace sink, silent without one
 
 public:
-    std::unordered_set<E *> *ground_set; // pointer to ground set of elements
-    int n = 0;                           // holds size of ground set, indexed from 0 to n-1
+    groundset::GroundSet<E> *ground_set = nullptr; // pointer to dense, id-indexed ground set of elements
+    int n = 0;                                     // holds size of ground set, indexed from 0 to n-1
     costfunction::CostFunction<E> *cost_function;
     std::unordered_set<E *> curr_set;
     double curr_val = 0; // current value of elements in set
 
-    void set_ground_set(std::unordered_set<E *> *V)
+    void set_ground_set(groundset::GroundSet<E> *V)
     {
         this->ground_set = V;
         this->n = V->size();
-    };
+    }
+
+    void set_ground_set(std::unordered_set<E *> *V)
+    {
+        // number the elements once, then work on the dense ground set
+        this->owned_ground_set = groundset::GroundSet<E>(*V);
+        this->set_ground_set(&(this->owned_ground_set));
+    }
 
     void set_cost_function(costfunction::CostFunction<E> *F)
     {
@@ -41,6 +56,28 @@ public:
         this->randomized = random;
     }
 
+    const telemetry::OptimizerStats &stats() const
+    {
+        return this->run_stats;
+    }
+
+    void set_trace_sink(telemetry::TraceSink *sink)
+    {
+        // per-iteration events (and, at TraceLevel::DEBUG, the current set) go to sink; nullptr silences them
+        this->tracer.sink = sink;
+    }
+
+    void set_stopping_policy(const stopping::StoppingPolicy &policy)
+    {
+        // a run stops at the first of its limits, or when no element can be added
+        this->stopping_policy = policy;
+    }
+
+    stopping::StopReason stop_reason() const
+    {
+        return this->stopping_policy.reason;
+    }
+
     void add_constraint(constraint::Constraint<E> *C)
     {
         std::cout << "Bidirectional greedy is only valid for unconstrained problems, ignoring..." << std::endl;
@@ -56,42 +93,49 @@ public:
         }
         else
         {
-            this->top_set = *ground_set;
+            this->top_set = ground_set->to_set();
             this->bottom_set.clear();
             this->top_val = cost_function->evaluate(top_set);
-            this->bottom_val = 0;
-            this->MAXITER = this->n;
+            this->run_stats.clear();
+            this->stopping_policy.start();
+            this->run_stats.oracle_evaluations++;
+            this->bottom_state = cost_function->new_state(this->ground_set);
+            this->bottom_val = bottom_state->value;
+            this->keep_best();
             int counter = 0;
-            for (auto it = ground_set->begin(); it != ground_set->end(); ++it)
+            for (uint32_t id = 0; id < uint32_t(n); id++)
             {
-                counter++;
-                greedy_step(*it);
-                if (this->randomized)
+                // max_elements limits the growing bottom set, and keep_best only returns the top set once it fits too
+                if (stopping_policy.reached(run_stats, bottom_set.size(), curr_val))
                 {
-                    std::cout << "Performed RANDOMIZED BIDIRECTIONAL greedy algorithm iteration: " << counter << std::endl;
-                }
-                else
-                {
-                    std::cout << "Performed BIDIRECTIONAL greedy algorithm iteration: " << counter << std::endl;
+                    break;
                 }
-                this->curr_set = (top_val > bottom_val) ? top_set : bottom_set;
-                this->curr_val = std::max(top_val, bottom_val);
-
-                if (this->top_set == this->bottom_set)
+                counter++;
+                telemetry::IterationTimer timer;
+                double prev_val = curr_val;
+                greedy_step((*ground_set)[id]);
+                this->keep_best();
+                timer.record(run_stats, curr_val - prev_val);
+                tracer.iteration(optimizer_name(), counter, run_stats, curr_set.size(), curr_val, false);
+
+                if (this->top_set.size() == this->bottom_set.size())
                 {
+                    // bottom_set only grows inside top_set, so they meet once their sizes do
                     break;
                 }
 
-                print_status();
+                tracer.debug([&](auto &os)
+                             { this->print_status(os); });
             }
+            tracer.run(optimizer_name(), run_stats, curr_set.size(), curr_val);
         }
     };
 
-    void print_status()
+    void print_status(std::ostream &os = std::cout)
     {
-        std::cout << "Current set:";
-        std::cout << curr_set;
-        std::cout << "Current val: " << curr_val << std::endl;
+        os << "Current set:";
+        os << curr_set;
+        os << "Current val: " << curr_val << std::endl;
     };
 
     void clear_set()
@@ -103,19 +147,37 @@ public:
     };
 
 private:
+    void keep_best()
+    {
+        // the better of the two sets, where the top set only counts once it has at most max_elements elements
+        if (top_val > bottom_val && top_set.size() <= stopping_policy.max_elements)
+        {
+            this->curr_set = top_set;
+            this->curr_val = top_val;
+        }
+        else
+        {
+            this->curr_set = bottom_set;
+            this->curr_val = bottom_val;
+        }
+    }
+
+    const char *optimizer_name() const
+    {
+        return this->randomized ? "RandomizedBidirectionalGreedy" : "BidirectionalGreedy";
+    }
+
     void greedy_step(E *el)
     {
-        std::unordered_set<E *> test_set(bottom_set);
         double bottom_gain, top_gain;
 
-        test_set = bottom_set;
-
-        test_set.insert(el);
-        bottom_gain = cost_function->evaluate(test_set) - bottom_val;
+        bottom_gain = cost_function->gain(bottom_state.get(), el);
 
-        test_set = top_set;
-        test_set.erase(el);
-        top_gain = cost_function->evaluate(test_set) - top_val;
+        // the oracle only grows sets, so evaluate the top set with el taken out and put it back
+        top_set.erase(el);
+        top_gain = cost_function->evaluate(top_set) - top_val;
+        top_set.insert(el);
+        run_stats.oracle_evaluations = run_stats.oracle_evaluations + 2;
 
         if (this->randomized)
         {
@@ -124,16 +186,14 @@ private:
             if (denom == 0.0)
             {
                 // in this case, we default to the bottom set
-                bottom_set.insert(el);
-                bottom_val = bottom_val + bottom_gain;
+                add_to_bottom(el);
             }
             else
             {
                 // otherwise, we do a weighted randomized draw
                 if (double(std::rand()) / RAND_MAX <= std::max(0.0, bottom_gain) / denom)
                 {
-                    bottom_set.insert(el);
-                    bottom_val = bottom_val + bottom_gain;
+                    add_to_bottom(el);
                 }
                 else
                 {
@@ -146,10 +206,8 @@ private:
         {
             if (bottom_gain >= top_gain)
             {
-                // then add the element to the bottom set
-                bottom_set.insert(el);
-                // update current bottom set value
-                bottom_val = bottom_val + bottom_gain;
+                // then add the element to the bottom set, updating current bottom set value
+                add_to_bottom(el);
             }
             else
             {
@@ -158,4 +216,10 @@ private:
             }
         }
     };
+    void add_to_bottom(E *el)
+    {
+        bottom_set.insert(el);
+        cost_function->commit(bottom_state.get(), el);
+        bottom_val = bottom_state->value;
+    };
 };
\ No newline at end of file
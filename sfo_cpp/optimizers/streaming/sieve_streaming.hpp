@@ -0,0 +1,293 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <unordered_set>
+#include "../../sfo_concepts/element.hpp"
+#include "../../sfo_concepts/ground_set.hpp"
+#include "../../sfo_concepts/cost_function.hpp"
+#include "../../sfo_concepts/constraint.hpp"
+#include "../../utils/telemetry.hpp"
+
+template <typename E>
+class SieveStreaming
+{
+    /* Single pass Sieve-Streaming (Badanidiyuru, Mirzasoleiman, Karbasi and Krause, 2014) under a cardinality
+     *  constraint k. Given the largest singleton value m seen so far, OPT lies in [m, k m], so it keeps one
+     *  candidate solution ("sieve") per threshold v = (1 + epsilon)^i in [m, 2 k m]. A sieve takes an element
+     *  when it is not full and the element's marginal is at least (v / 2 - F(S_v)) / (k - |S_v|). Sieves are
+     *  started empty as m grows and retired once they fall below it, so at most O(log(k) / epsilon) of them,
+     *  each holding at most k elements, are alive at any time, however long the stream. The best of them is
+     *  a (1/2 - epsilon) approximation.
+     *
+     *  Elements are pushed one at a time (or as an iterator range) and only looked at once.
+     */
+private:
+    struct Sieve
+    {
+        double threshold;                                    // guess v of the optimal value
+        std::unique_ptr<costfunction::OracleState<E>> state; // its candidate solution
+    };
+    std::deque<Sieve> sieves;                                  // live sieves, by increasing threshold index
+    int first_index = 0;                                       // grid index i of sieves.front(), v = (1 + epsilon)^i
+    double max_singleton = 0;                                  // m, the largest singleton value seen so far
+    std::unique_ptr<costfunction::OracleState<E>> empty_state; // evaluates singletons
+    std::unique_ptr<costfunction::OracleState<E>> retired;     // best solution of the sieves retired so far
+    uint32_t k = 0;                                            // cardinality budget
+    groundset::GroundSet<E> owned_ground_set;                  // backs ground_set when handed a std::unordered_set
+    telemetry::OptimizerStats run_stats;                       // counters since the last clear_set
+    telemetry::Tracer tracer;                                  // optional trace sink, silent without one
+
+public:
+    double curr_val = 0;                           // value of the best candidate solution so far
+    uint64_t num_seen = 0;                         // elements pushed since the last clear_set
+    groundset::GroundSet<E> *ground_set = nullptr; // optional, streamed in id order by run_greedy
+    std::unordered_set<constraint::Constraint<E> *> constraint_set;
+    costfunction::CostFunction<E> *cost_function = nullptr;
+    double epsilon = 0.1;             // spacing of the threshold grid
+    std::unordered_set<E *> curr_set; // filled in with the best candidate solution by solution()
+
+    void set_ground_set(groundset::GroundSet<E> *V)
+    {
+        this->ground_set = V;
+    }
+
+    void set_ground_set(std::unordered_set<E *> *V)
+    {
+        this->owned_ground_set = groundset::GroundSet<E>(*V);
+        this->set_ground_set(&(this->owned_ground_set));
+    }
+
+    void add_constraint(constraint::Constraint<E> *C)
+    {
+        this->constraint_set.insert(C);
+    }
+
+    void remove_constraint(constraint::Constraint<E> *C)
+    {
+        this->constraint_set.erase(C);
+    }
+
+    void set_cost_function(costfunction::CostFunction<E> *F)
+    {
+        this->cost_function = F;
+    }
+
+    void set_epsilon(double epsilon)
+    {
+        this->epsilon = epsilon;
+    }
+
+    const telemetry::OptimizerStats &stats() const
+    {
+        // only counters, a stream has no iterations to time
+        return this->run_stats;
+    }
+
+    void set_trace_sink(telemetry::TraceSink *sink)
+    {
+        // a run event at the end of run_greedy and consume (and, at TraceLevel::DEBUG, the solution) go to sink
+        this->tracer.sink = sink;
+    }
+
+    bool is_configured()
+    {
+        if (!this->cost_function)
+        {
+            std::cout << "No cost function given!" << std::endl;
+            return false;
+        }
+        else if (!(find_single_cardinality() && constraint_set.size() == 1))
+        {
+            std::cout << "Constraint is not a single cardinality constraint, sieve streaming is not valid." << std::endl;
+            return false;
+        }
+        else if (!(this->epsilon > 0))
+        {
+            std::cout << "Sieve streaming needs epsilon > 0!" << std::endl;
+            return false;
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    void clear_set()
+    {
+        // forget the stream so far, the next push starts a new one
+        this->sieves.clear();
+        this->first_index = 0;
+        this->max_singleton = 0;
+        this->retired.reset();
+        this->curr_set.clear();
+        this->curr_val = 0;
+        this->num_seen = 0;
+        this->run_stats.clear();
+        if (this->cost_function)
+        {
+            this->empty_state = this->cost_function->new_state();
+            this->curr_val = this->empty_state->value;
+        }
+        constraint::Cardinality<E> *C = find_single_cardinality();
+        this->k = C ? uint32_t(std::max(0.0, C->budget)) : 0;
+    }
+
+    void push(E *el)
+    {
+        // one element of the stream, which is not looked at again
+        if (!empty_state)
+        {
+            if (!this->is_configured())
+            {
+                return;
+            }
+            this->clear_set();
+        }
+        num_seen++;
+
+        double singleton = cost_function->gain(empty_state.get(), el);
+        run_stats.oracle_evaluations++;
+        if (singleton > max_singleton)
+        {
+            max_singleton = singleton;
+            this->update_thresholds();
+        }
+
+        for (auto &sieve : sieves)
+        {
+            std::size_t size = sieve.state->set.size();
+            run_stats.constraint_checks++;
+            if (size >= k)
+            {
+                continue;
+            }
+            double gain = cost_function->gain(sieve.state.get(), el);
+            run_stats.oracle_evaluations++;
+            if (gain > 0 && gain >= (sieve.threshold / 2 - sieve.state->value) / double(k - size))
+            {
+                cost_function->commit(sieve.state.get(), el);
+                curr_val = std::max(curr_val, sieve.state->value);
+            }
+        }
+    }
+
+    template <typename Iterator>
+    void consume(Iterator begin, Iterator end)
+    {
+        // pushes every element of [begin, end), e.g. a batch read off the stream
+        for (; begin != end; ++begin)
+        {
+            this->push(*begin);
+        }
+        this->trace_run("SieveStreaming");
+    }
+
+    void run_greedy()
+    {
+        // streams the ground set once, in id order, so the optimizer can stand in for the offline ones
+        if (!this->ground_set)
+        {
+            std::cout << "No ground set given!" << std::endl;
+            return;
+        }
+        if (this->is_configured())
+        {
+            this->clear_set();
+            this->consume(ground_set->elements.begin(), ground_set->elements.end());
+            this->solution();
+        }
+    }
+
+    std::unordered_set<E *> &solution()
+    {
+        // copies the best candidate solution so far into curr_set
+        costfunction::OracleState<E> *best = this->best_state();
+        curr_set = best ? best->set : std::unordered_set<E *>();
+        return curr_set;
+    }
+
+    std::size_t num_sieves() const
+    {
+        return sieves.size();
+    }
+
+    void print_status(std::ostream &os = std::cout)
+    {
+        os << "Current set:";
+        os << this->solution();
+        os << "Current val: " << curr_val << std::endl;
+        os << "Elements seen: " << num_seen << ", live sieves: " << sieves.size() << std::endl;
+    };
+
+private:
+    costfunction::OracleState<E> *best_state()
+    {
+        // the state of the best candidate solution so far, nullptr before any
+        costfunction::OracleState<E> *best = retired.get();
+        for (auto &sieve : sieves)
+        {
+            if (!best || sieve.state->value > best->value)
+            {
+                best = sieve.state.get();
+            }
+        }
+        return best;
+    }
+
+    void trace_run(const char *optimizer)
+    {
+        // only the size of the best solution, which is not copied into curr_set until solution() is asked for
+        costfunction::OracleState<E> *best = this->best_state();
+        tracer.run(optimizer, run_stats, best ? best->set.size() : 0, curr_val);
+        tracer.debug([&](auto &os)
+                     { this->print_status(os); });
+    }
+
+    void update_thresholds()
+    {
+        /* Keeps exactly the sieves with m <= (1 + epsilon)^i <= 2 k m alive. Both ends of the range only move up,
+         *  so sieves are retired from the front and started at the back.
+         */
+        double base = std::log1p(epsilon);
+        int lowest = int(std::ceil(std::log(max_singleton) / base));
+        int highest = int(std::floor(std::log(2 * double(std::max(k, uint32_t(1))) * max_singleton) / base));
+
+        while (!sieves.empty() && first_index < lowest)
+        {
+            // a retired sieve's solution may still be the best one, so keep that
+            if (!retired || sieves.front().state->value > retired->value)
+            {
+                retired = std::move(sieves.front().state);
+            }
+            sieves.pop_front();
+            first_index++;
+        }
+        if (sieves.empty())
+        {
+            first_index = lowest;
+        }
+        for (int i = first_index + int(sieves.size()); i <= highest; i++)
+        {
+            sieves.push_back({std::pow(1 + epsilon, i), cost_function->new_state()});
+        }
+    }
+
+    constraint::Cardinality<E> *find_single_cardinality()
+    {
+        constraint::Cardinality<E> *cardinality_ptr;
+        for (auto it = constraint_set.begin(); it != constraint_set.end(); ++it)
+        {
+            // iterate over constraints in set, looking for one that can be cast to cardinality
+            cardinality_ptr = dynamic_cast<constraint::Cardinality<E> *>(*it);
+            if (cardinality_ptr != nullptr)
+            {
+                return cardinality_ptr;
+            }
+        }
+        return nullptr;
+    }
+};
@@ -0,0 +1,296 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+#include "cost_function.hpp"
+#include "ground_set.hpp"
+
+namespace costfunction
+{
+    class ValueCache
+    {
+        /* Bounded open addressing table from 64 bit keys to doubles, safe to use from several threads at once.
+         *  A key is looked for in PROBES slots from its home slot. An insert takes the first empty slot among
+         *  them, or evicts the entry in the home slot if they are all taken. Writers claim a slot by swapping its
+         *  key for BUSY, write the value, then publish the key, and readers check the key again after reading the
+         *  value, so a reader never sees a value with the wrong key. Key 0 marks an empty slot.
+         */
+    public:
+        static constexpr std::size_t PROBES = 8;
+
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+
+        ValueCache(std::size_t capacity)
+        {
+            // rounded up to a power of two, of at least PROBES slots
+            std::size_t slots = PROBES;
+            while (slots < capacity)
+            {
+                slots = 2 * slots;
+            }
+            table = std::vector<Slot>(slots);
+            mask = slots - 1;
+        }
+
+        std::size_t capacity() const
+        {
+            return table.size();
+        }
+
+        bool find(uint64_t key, double &value)
+        {
+            key = usable(key);
+            for (std::size_t i = 0; i < PROBES; i++)
+            {
+                Slot &slot = table[(key + i) & mask];
+                uint64_t found = slot.key.load(std::memory_order_acquire);
+                if (found == EMPTY)
+                {
+                    break;
+                }
+                if (found == key)
+                {
+                    uint64_t bits = slot.value.load(std::memory_order_acquire);
+                    if (slot.key.load(std::memory_order_acquire) == key)
+                    {
+                        std::memcpy(&value, &bits, sizeof(double));
+                        hits.fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+            }
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        void insert(uint64_t key, const double &value)
+        {
+            // a slot another thread is writing to is skipped, so an insert may be dropped, which only costs a miss later
+            key = usable(key);
+            std::size_t target = key & mask; // evict the home slot's entry if no slot is free
+            for (std::size_t i = 0; i < PROBES; i++)
+            {
+                std::size_t s = (key + i) & mask;
+                uint64_t found = table[s].key.load(std::memory_order_relaxed);
+                if (found == key)
+                {
+                    return;
+                }
+                if (found == EMPTY)
+                {
+                    target = s;
+                    break;
+                }
+            }
+
+            Slot &slot = table[target];
+            uint64_t previous = slot.key.load(std::memory_order_relaxed);
+            if (previous == BUSY || !slot.key.compare_exchange_strong(previous, BUSY, std::memory_order_acquire))
+            {
+                return;
+            }
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(double));
+            slot.value.store(bits, std::memory_order_release);
+            slot.key.store(key, std::memory_order_release);
+        }
+
+        void clear()
+        {
+            // not safe while other threads use the cache
+            for (auto &slot : table)
+            {
+                slot.key.store(EMPTY, std::memory_order_relaxed);
+            }
+            hits = 0;
+            misses = 0;
+        }
+
+    private:
+        static constexpr uint64_t EMPTY = 0;
+        static constexpr uint64_t BUSY = 1;
+
+        struct Slot
+        {
+            std::atomic<uint64_t> key{EMPTY};
+            std::atomic<uint64_t> value{0}; // bits of the double
+        };
+        std::vector<Slot> table;
+        std::size_t mask = 0;
+
+        static uint64_t usable(const uint64_t &key)
+        {
+            // keeps EMPTY and BUSY free, at the cost of sharing a slot between three of 2^64 keys
+            return (key < 2) ? key + 2 : key;
+        }
+    };
+
+    template <typename E>
+    class CachedState : public OracleState<E>
+    {
+        // the wrapped cost function's state, and the Zobrist hash of the committed set
+    public:
+        std::unique_ptr<OracleState<E>> inner;
+        uint64_t hash = 0;
+    };
+
+    template <typename E>
+    class CachedCostFunction : public CostFunction<E>
+    {
+        /* Memoizes another cost function, for oracles that are expensive enough (a remote feature store, a model)
+         *  that repeated calls are worth a table lookup. Any optimizer can use it in place of the cost function
+         *  it wraps. Sets are hashed Zobrist style, as the XOR of a random 64 bit key per element, so the state
+         *  updates its hash in O(1) on commit and evaluate(set) costs one pass over the set. Two kinds of
+         *  results share one ValueCache:
+         *   - F(S), keyed by the hash of S, from evaluate and from every committed state;
+         *   - the marginal gain of e on S, keyed by the hash of S XOR a second key of e, from gain and gains.
+         *  So the same (set, element) pair is evaluated once across steps and repeated runs, however the set was
+         *  built. Keys are derived from element addresses, so entries are only shared by elements that stay put.
+         *  Distinct sets can collide with probability about 2^-64 per pair, in which case a stale value is used.
+         */
+    public:
+        CostFunction<E> *inner;
+        ValueCache cache;
+
+        CachedCostFunction(CostFunction<E> *F, std::size_t capacity = std::size_t(1) << 20, uint64_t seed = 0x5DEECE66D)
+            : inner(F), cache(capacity), seed(seed)
+        {
+        }
+
+        uint64_t hits() const
+        {
+            return cache.hits.load();
+        }
+
+        uint64_t misses() const
+        {
+            return cache.misses.load();
+        }
+
+        double evaluate(std::unordered_set<E *> &set)
+        {
+            uint64_t hash = 0;
+            for (auto el : set)
+            {
+                hash = hash ^ this->set_key(el);
+            }
+            double value;
+            if (!cache.find(hash, value))
+            {
+                value = inner->evaluate(set);
+                cache.insert(hash, value);
+            }
+            return value;
+        }
+
+        double evaluate(E *&el)
+        {
+            double value;
+            if (!cache.find(this->set_key(el), value))
+            {
+                value = inner->evaluate(el);
+                cache.insert(this->set_key(el), value);
+            }
+            return value;
+        }
+
+        std::unique_ptr<OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            std::unique_ptr<CachedState<E>> state(new CachedState<E>);
+            state->inner = inner->new_state(V);
+            state->value = state->inner->value;
+            state->ground_set = V;
+            cache.insert(0, state->value);
+            return state;
+        }
+
+        double gain(OracleState<E> *state, E *el)
+        {
+            CachedState<E> *S = static_cast<CachedState<E> *>(state);
+            uint64_t key = S->hash ^ this->candidate_key(el);
+            double value;
+            if (!cache.find(key, value))
+            {
+                value = inner->gain(S->inner.get(), el);
+                cache.insert(key, value);
+            }
+            return value;
+        }
+
+        void gains(OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+        {
+            // looks every id up, then hands the misses to the wrapped batch oracle at once
+            CachedState<E> *S = static_cast<CachedState<E> *>(state);
+            MissBuffers misses = std::move(spare_buffers); // taken out while in use, so a nested call gets its own
+            misses.ids.clear();
+            misses.positions.clear();
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (!cache.find(S->hash ^ this->candidate_key((*state->ground_set)[ids[i]]), out[i]))
+                {
+                    misses.ids.push_back(ids[i]);
+                    misses.positions.push_back(i);
+                }
+            }
+            if (!misses.ids.empty())
+            {
+                misses.gains.resize(misses.ids.size());
+                inner->gains(S->inner.get(), misses.ids.data(), misses.ids.size(), misses.gains.data());
+                for (std::size_t m = 0; m < misses.ids.size(); m++)
+                {
+                    out[misses.positions[m]] = misses.gains[m];
+                    cache.insert(S->hash ^ this->candidate_key((*state->ground_set)[misses.ids[m]]), misses.gains[m]);
+                }
+            }
+            spare_buffers = std::move(misses);
+        }
+
+        void commit(OracleState<E> *state, E *el)
+        {
+            // the wrapped state always follows along, only its value is remembered
+            CachedState<E> *S = static_cast<CachedState<E> *>(state);
+            inner->commit(S->inner.get(), el);
+            S->set.insert(el);
+            S->hash = S->hash ^ this->set_key(el);
+            S->value = S->inner->value;
+            cache.insert(S->hash, S->value);
+        }
+
+    private:
+        uint64_t seed; // picks the element keys
+
+        struct MissBuffers
+        {
+            // ids of a batch that missed the cache, where they were in the batch, and their gains
+            std::vector<uint32_t> ids;
+            std::vector<std::size_t> positions;
+            std::vector<double> gains;
+        };
+        // per thread, since the parallel optimizers call gains from several threads on the same state
+        static inline thread_local MissBuffers spare_buffers;
+
+        static uint64_t mix(uint64_t x)
+        {
+            // splitmix64 finalizer
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        }
+
+        uint64_t set_key(E *el) const
+        {
+            // el's Zobrist key as a member of a set
+            return mix(uint64_t(reinterpret_cast<uintptr_t>(el)) ^ seed);
+        }
+
+        uint64_t candidate_key(E *el) const
+        {
+            // el's key as the element whose gain is asked for, unrelated to its set key
+            return mix(set_key(el) + 0x9E3779B97F4A7C15ull);
+        }
+    };
+}
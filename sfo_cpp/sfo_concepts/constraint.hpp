@@ -3,10 +3,23 @@
 #include "cost_function.hpp"
 #include <unordered_set>
 #include <iostream>
+#include <memory>
+#include <vector>
+#include <cstdint>
 #include "element.hpp"
 
 namespace constraint
 {
+    template <typename E>
+    class ConstraintState
+    {
+        // State of the solution an optimizer is building, handed back to the constraint on every
+        // can_add/commit/saturated call, like costfunction::OracleState is to cost functions.
+    public:
+        virtual ~ConstraintState(){};
+        std::unordered_set<E *> set; // elements committed so far, only kept by the fallback
+    };
+
     template <typename E>
     class Constraint
     {
@@ -35,6 +48,39 @@ namespace constraint
         {
             return false;
         }
+
+        // stateful (incremental) feasibility checks
+        virtual std::unique_ptr<ConstraintState<E>> new_state()
+        {
+            // state for an empty solution, constraints that override can_add/commit also hand out their own
+            return std::unique_ptr<ConstraintState<E>>(new ConstraintState<E>);
+        }
+        virtual bool can_add(ConstraintState<E> *state, E *el)
+        {
+            /* Whether the solution held in state stays feasible with E* el added. el must not be committed yet.
+             *  Only reads state, so it can be called from several threads between commits.
+             *  Falls back to testing a copy of the set unless a derived class knows better.
+             */
+            std::unordered_set<E *> test_set(state->set);
+            test_set.insert(el);
+            return this->test_membership(test_set);
+        }
+        virtual void commit(ConstraintState<E> *state, E *el)
+        {
+            state->set.insert(el);
+        }
+        virtual bool saturated(ConstraintState<E> *state)
+        {
+            return this->is_saturated(state->set);
+        }
+    };
+
+    template <typename E>
+    class KnapsackState : public ConstraintState<E>
+    {
+        // running knapsack total of the committed elements
+    public:
+        double total = 0;
     };
 
     template <typename E>
@@ -88,6 +134,27 @@ namespace constraint
         {
             return modular.evaluate(el);
         }
+
+        std::unique_ptr<ConstraintState<E>> new_state()
+        {
+            return std::unique_ptr<ConstraintState<E>>(new KnapsackState<E>);
+        }
+
+        bool can_add(ConstraintState<E> *state, E *el)
+        {
+            return static_cast<KnapsackState<E> *>(state)->total + modular.weight(el) <= budget;
+        }
+
+        void commit(ConstraintState<E> *state, E *el)
+        {
+            KnapsackState<E> *knapsack_state = static_cast<KnapsackState<E> *>(state);
+            knapsack_state->total = knapsack_state->total + modular.weight(el);
+        }
+
+        bool saturated(ConstraintState<E> *state)
+        {
+            return std::abs(static_cast<KnapsackState<E> *>(state)->total - budget) < std::numeric_limits<float>::epsilon();
+        }
     };
 
     template <typename E>
@@ -97,4 +164,243 @@ namespace constraint
     public:
         Cardinality(const int &B) : Knapsack<E>(int(B)) {}
     };
-}
\ No newline at end of file
+
+    template <typename E>
+    class PartitionMatroidState : public ConstraintState<E>
+    {
+        // elements committed from each part, and how many parts are full
+    public:
+        std::vector<uint32_t> counts;
+        uint32_t full_parts = 0;
+    };
+
+    template <typename E>
+    class PartitionMatroid : public Constraint<E>
+    {
+        /* At most capacities[p] elements from each part p, e.g. per shard or per category caps.
+         *  Elements are mapped to dense part ids, so the stateful checks are one lookup and one counter compare.
+         *  Elements without a part can never be added, so the constraint is saturated once every part is full.
+         */
+    public:
+        static constexpr uint32_t NO_PART = UINT32_MAX;
+
+        std::unordered_map<E *, uint32_t> parts; // part id of each element
+        std::vector<uint32_t> capacities;        // cap of each part id
+
+        PartitionMatroid(const std::unordered_map<E *, uint32_t> &element_parts, const std::vector<uint32_t> &part_capacities)
+        {
+            parts = element_parts;
+            capacities = part_capacities;
+        }
+
+        uint32_t part(E *el) const
+        {
+            // read-only lookup, safe to call from several threads
+            auto it = parts.find(el);
+            return (it == parts.end()) ? NO_PART : it->second;
+        }
+
+        uint32_t num_parts() const
+        {
+            return uint32_t(capacities.size());
+        }
+
+        bool test_membership(E *el)
+        {
+            uint32_t p = part(el);
+            return p != NO_PART && capacities[p] >= 1;
+        }
+
+        bool test_membership(std::unordered_set<E *> &set)
+        {
+            std::vector<uint32_t> counts(capacities.size(), 0);
+            for (auto el : set)
+            {
+                uint32_t p = part(el);
+                if (p == NO_PART || ++counts[p] > capacities[p])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool is_saturated(E *el)
+        {
+            std::unordered_set<E *> set{el};
+            return this->is_saturated(set);
+        }
+
+        bool is_saturated(std::unordered_set<E *> &set)
+        {
+            // saturated once every part is full
+            std::vector<uint32_t> counts(capacities.size(), 0);
+            for (auto el : set)
+            {
+                if (uint32_t p = part(el); p != NO_PART)
+                {
+                    counts[p]++;
+                }
+            }
+            for (uint32_t p = 0; p < num_parts(); p++)
+            {
+                if (counts[p] < capacities[p])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::unique_ptr<ConstraintState<E>> new_state()
+        {
+            std::unique_ptr<PartitionMatroidState<E>> state(new PartitionMatroidState<E>);
+            state->counts.assign(capacities.size(), 0);
+            for (auto capacity : capacities)
+            {
+                state->full_parts = state->full_parts + (capacity == 0);
+            }
+            return state;
+        }
+
+        bool can_add(ConstraintState<E> *state, E *el)
+        {
+            uint32_t p = part(el);
+            return p != NO_PART && static_cast<PartitionMatroidState<E> *>(state)->counts[p] < capacities[p];
+        }
+
+        void commit(ConstraintState<E> *state, E *el)
+        {
+            PartitionMatroidState<E> *pm_state = static_cast<PartitionMatroidState<E> *>(state);
+            if (uint32_t p = part(el); p != NO_PART && ++pm_state->counts[p] == capacities[p])
+            {
+                pm_state->full_parts++;
+            }
+        }
+
+        bool saturated(ConstraintState<E> *state)
+        {
+            return static_cast<PartitionMatroidState<E> *>(state)->full_parts == num_parts();
+        }
+
+        bool is_full(ConstraintState<E> *state, const uint32_t &p) const
+        {
+            // whether part p can take no more elements
+            return static_cast<PartitionMatroidState<E> *>(state)->counts[p] >= capacities[p];
+        }
+    };
+
+    template <typename E>
+    class IntersectionState : public ConstraintState<E>
+    {
+        // running state of each member of an intersection, in member order
+    public:
+        std::vector<std::unique_ptr<ConstraintState<E>>> states;
+    };
+
+    template <typename E>
+    class Intersection : public Constraint<E>
+    {
+        /* All of members at once, e.g. the constraints an optimizer was handed at run time. Feasibility checks
+         *  go to each member in turn, stopping at the first that fails, and the intersection is saturated as soon
+         *  as any member is.
+         */
+    public:
+        std::vector<Constraint<E> *> members;
+
+        Intersection() {}
+
+        Intersection(const std::vector<Constraint<E> *> &constraints)
+        {
+            members = constraints;
+        }
+
+        bool test_membership(std::unordered_set<E *> &set)
+        {
+            for (auto C : members)
+            {
+                if (!C->test_membership(set))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool is_saturated(std::unordered_set<E *> &set)
+        {
+            for (auto C : members)
+            {
+                if (C->is_saturated(set))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::unique_ptr<ConstraintState<E>> new_state()
+        {
+            std::unique_ptr<IntersectionState<E>> state(new IntersectionState<E>);
+            for (auto C : members)
+            {
+                state->states.push_back(C->new_state());
+            }
+            return state;
+        }
+
+        bool can_add(ConstraintState<E> *state, E *el)
+        {
+            uint64_t checks = 0;
+            return this->can_add(state, el, checks);
+        }
+
+        bool can_add(ConstraintState<E> *state, E *el, uint64_t &checks)
+        {
+            // counts a check per member asked, as the optimizers count them
+            IntersectionState<E> *intersection_state = static_cast<IntersectionState<E> *>(state);
+            for (std::size_t i = 0; i < members.size(); i++)
+            {
+                checks++;
+                if (!members[i]->can_add(intersection_state->states[i].get(), el))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void commit(ConstraintState<E> *state, E *el)
+        {
+            IntersectionState<E> *intersection_state = static_cast<IntersectionState<E> *>(state);
+            for (std::size_t i = 0; i < members.size(); i++)
+            {
+                members[i]->commit(intersection_state->states[i].get(), el);
+            }
+        }
+
+        bool saturated(ConstraintState<E> *state)
+        {
+            IntersectionState<E> *intersection_state = static_cast<IntersectionState<E> *>(state);
+            for (std::size_t i = 0; i < members.size(); i++)
+            {
+                if (members[i]->saturated(intersection_state->states[i].get()))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template <typename Fn>
+        void for_each_member(ConstraintState<E> *state, Fn fn)
+        {
+            // fn(member, its running state) for every member, with nullptr states if state is nullptr
+            IntersectionState<E> *intersection_state = static_cast<IntersectionState<E> *>(state);
+            for (std::size_t i = 0; i < members.size(); i++)
+            {
+                fn(members[i], intersection_state ? intersection_state->states[i].get() : nullptr);
+            }
+        }
+    };
+}
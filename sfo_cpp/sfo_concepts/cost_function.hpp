@@ -3,10 +3,27 @@
 #include <unordered_map>
 #include <vector>
 #include <cmath>
+#include <memory>
+#include <cstdint>
 #include "element.hpp"
+#include "ground_set.hpp"
+#include "../utils/simd.hpp"
 
 namespace costfunction
 {
+    template <typename E>
+    class OracleState
+    {
+        // Opaque state of the solution an optimizer is building, handed back to the cost function
+        // on every gain/commit call. Cost functions that can compute marginal gains incrementally
+        // derive from this to keep their own running quantities next to the committed set.
+    public:
+        virtual ~OracleState(){};
+        std::unordered_set<E *> set;                   // elements committed so far
+        double value = 0;                              // cost function value of set
+        groundset::GroundSet<E> *ground_set = nullptr; // ground set that ids handed to the batch oracle refer to
+    };
+
     template <typename E>
     class CostFunction
     {
@@ -35,6 +52,54 @@ namespace costfunction
             testset.insert(el);
             return this->evaluate(testset) - curr_val;
         }
+
+        // stateful (incremental) oracle
+        virtual std::unique_ptr<OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            /* Build the state for an empty solution, optionally over the ground set V (needed by gains).
+             *  Cost functions that override gain/commit should also override this to hand out their own state.
+             */
+            std::unique_ptr<OracleState<E>> state(new OracleState<E>);
+            state->value = this->evaluate(state->set);
+            state->ground_set = V;
+            return state;
+        }
+        virtual double gain(OracleState<E> *state, E *el)
+        {
+            /* Evaluate the marginal gain of E* el when added to the solution held in state.
+             *  el must not already be committed to state.
+             *  Falls back to copying the set and re-evaluating unless a derived class knows better.
+             */
+            return this->marginal_gain(el, state->set, state->value);
+        }
+        virtual void gains(OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+        {
+            /* Evaluate the marginal gains of count ground set ids at once, writing them to out.
+             *  state must have been built over a ground set, which the ids refer to.
+             *  Falls back to one gain call per id unless a derived class can vectorize across candidates.
+             */
+            for (std::size_t i = 0; i < count; i++)
+            {
+                out[i] = this->gain(state, (*state->ground_set)[ids[i]]);
+            }
+        }
+        virtual void commit(OracleState<E> *state, E *el)
+        {
+            /* Add E* el to the solution held in state.
+             *  Falls back to re-evaluating the (uncopied) set unless a derived class knows better.
+             */
+            state->set.insert(el);
+            state->value = this->evaluate(state->set);
+        }
+    };
+
+    template <typename E>
+    class ModularState : public OracleState<E>
+    {
+        // running modular total, used by the modular and square root cost functions
+    public:
+        double total = 0;
+        std::vector<double> weights; // weights by ground set id, if built over a ground set
     };
 
     template <typename E>
@@ -68,21 +133,66 @@ namespace costfunction
             double val = 0;
             for (auto el : set)
             {
-                val = val + weights[el];
+                val = val + weight(el);
             }
             return val;
         }
 
         double evaluate(E *&el)
         {
+            return weight(el);
+        }
+
+        double weight(E *el) const
+        {
+            // read-only lookup, unknown elements weigh nothing (safe to call from several threads)
             if (weights.size() == 1)
             {
                 return (weights.begin()->second);
             }
-            else
+            auto it = weights.find(el);
+            return (it == weights.end()) ? 0 : it->second;
+        }
+
+        std::unique_ptr<ModularState<E>> new_modular_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            // looks every ground set weight up once, so batches can read them by id
+            std::unique_ptr<ModularState<E>> state(new ModularState<E>);
+            state->ground_set = V;
+            if (V)
             {
-                return weights[el];
+                state->weights.resize(V->size());
+                for (uint32_t id = 0; id < V->size(); id++)
+                {
+                    state->weights[id] = weight((*V)[id]);
+                }
             }
+            return state;
+        }
+
+        std::unique_ptr<OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            return new_modular_state(V);
+        }
+
+        double gain(OracleState<E> *, E *el)
+        {
+            return weight(el);
+        }
+
+        void gains(OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+        {
+            ModularState<E> *modular_state = static_cast<ModularState<E> *>(state);
+            simd::gather_transform(modular_state->weights.data(), ids, count, out, [](auto w)
+                                   { return w; });
+        }
+
+        void commit(OracleState<E> *state, E *el)
+        {
+            ModularState<E> *modular_state = static_cast<ModularState<E> *>(state);
+            modular_state->set.insert(el);
+            modular_state->total = modular_state->total + weight(el);
+            modular_state->value = modular_state->total;
         }
     };
 
@@ -111,6 +221,34 @@ namespace costfunction
         {
             return std::sqrt(modular_part.evaluate(el));
         }
+
+        std::unique_ptr<OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            return modular_part.new_modular_state(V);
+        }
+
+        double gain(OracleState<E> *state, E *el)
+        {
+            double total = static_cast<ModularState<E> *>(state)->total + modular_part.weight(el);
+            return std::sqrt(total) - state->value;
+        }
+
+        void gains(OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+        {
+            ModularState<E> *modular_state = static_cast<ModularState<E> *>(state);
+            double total = modular_state->total;
+            double value = modular_state->value;
+            simd::gather_transform(modular_state->weights.data(), ids, count, out, [=](auto w)
+                                   { return simd::sqrt(total + w) - value; });
+        }
+
+        void commit(OracleState<E> *state, E *el)
+        {
+            ModularState<E> *modular_state = static_cast<ModularState<E> *>(state);
+            modular_state->set.insert(el);
+            modular_state->total = modular_state->total + modular_part.weight(el);
+            modular_state->value = std::sqrt(modular_state->total);
+        }
     };
 
     template <typename E>
@@ -143,5 +281,45 @@ namespace costfunction
         {
             return high - std::sqrt(std::abs(modular_part.evaluate(el) - bias));
         }
+
+        double evaluate(std::unordered_set<E *> &set)
+        {
+            return (*this)(set);
+        }
+
+        double evaluate(E *&el)
+        {
+            return (*this)(el);
+        }
+
+        std::unique_ptr<OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            std::unique_ptr<ModularState<E>> state = modular_part.new_modular_state(V);
+            state->value = high - std::sqrt(std::abs(bias));
+            return state;
+        }
+
+        double gain(OracleState<E> *state, E *el)
+        {
+            double total = static_cast<ModularState<E> *>(state)->total + modular_part.weight(el);
+            return high - std::sqrt(std::abs(total - bias)) - state->value;
+        }
+
+        void gains(OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+        {
+            ModularState<E> *modular_state = static_cast<ModularState<E> *>(state);
+            double shift = modular_state->total - bias;
+            double offset = high - modular_state->value;
+            simd::gather_transform(modular_state->weights.data(), ids, count, out, [=](auto w)
+                                   { return offset - simd::sqrt(simd::abs(shift + w)); });
+        }
+
+        void commit(OracleState<E> *state, E *el)
+        {
+            ModularState<E> *modular_state = static_cast<ModularState<E> *>(state);
+            modular_state->set.insert(el);
+            modular_state->total = modular_state->total + modular_part.weight(el);
+            modular_state->value = high - std::sqrt(std::abs(modular_state->total - bias));
+        }
     };
 }
\ No newline at end of file
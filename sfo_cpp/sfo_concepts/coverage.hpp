@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "cost_function.hpp"
+#include "ground_set.hpp"
+#include "../utils/simd.hpp"
+
+namespace costfunction
+{
+    template <typename E>
+    class CoverageState : public OracleState<E>
+    {
+        // universe items covered by the committed elements, one bit each
+    public:
+        std::vector<uint64_t> covered;
+        std::vector<uint32_t> columns; // coverage index of each ground set id, or NO_COLUMN
+    };
+
+    template <typename E>
+    class WeightedCoverage : public CostFunction<E>
+    {
+        /* F(S) = total weight of the universe items covered by at least one element of S.
+         *  Elements covering many items keep their coverage as a packed bitset over the universe, so a gain is a
+         *  word-wise AND-NOT against the covered bitset plus a popcount. Elements covering few items keep a sorted
+         *  list of item ids instead, and a gain only tests those bits. Non-uniform item weights are summed over the
+         *  newly covered bits instead of counted.
+         */
+    public:
+        static constexpr uint32_t NO_COLUMN = UINT32_MAX;
+        static constexpr uint32_t NO_BITSET = UINT32_MAX;
+
+        groundset::GroundSet<E> columns; // element of each coverage entry
+        uint32_t universe = 0;           // number of items to cover
+        uint32_t words = 0;              // 64 bit words per bitset
+        std::vector<double> weights;     // weight of each item, empty if every item weighs 1
+
+        std::vector<uint32_t> bitset_index; // row of each element in bitsets, or NO_BITSET if it keeps a list
+        std::vector<uint64_t> bitsets;      // words per row
+        std::vector<std::size_t> offsets;   // each list element's range in items
+        std::vector<uint32_t> items;        // sorted item ids of the list elements
+
+        WeightedCoverage(const groundset::GroundSet<E> &V, const std::vector<std::vector<uint32_t>> &covers, const uint32_t &universe_size, const std::vector<double> &item_weights = {})
+        {
+            /* covers[j] lists the items covered by the element with id j in V.
+             *  An element is stored as a bitset once its list would take more room than one.
+             */
+            columns = V;
+            universe = universe_size;
+            words = (universe + 63) / 64;
+            weights = item_weights;
+
+            offsets.push_back(0);
+            for (uint32_t j = 0; j < columns.size(); j++)
+            {
+                if (covers[j].size() > 2 * std::size_t(words))
+                {
+                    bitset_index.push_back(uint32_t(bitsets.size() / words));
+                    bitsets.resize(bitsets.size() + words, 0);
+                    uint64_t *row = bitsets.data() + std::size_t(bitset_index.back()) * words;
+                    for (auto item : covers[j])
+                    {
+                        row[item >> 6] |= uint64_t(1) << (item & 63);
+                    }
+                }
+                else
+                {
+                    bitset_index.push_back(NO_BITSET);
+                    std::vector<uint32_t> sorted(covers[j]);
+                    std::sort(sorted.begin(), sorted.end());
+                    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+                    items.insert(items.end(), sorted.begin(), sorted.end());
+                }
+                offsets.push_back(items.size());
+            }
+        }
+
+        double evaluate(std::unordered_set<E *> &set)
+        {
+            std::vector<uint64_t> covered(words, 0);
+            double val = 0;
+            for (auto el : set)
+            {
+                val = val + column_gain(covered, column(el));
+                cover(covered, column(el));
+            }
+            return val;
+        }
+
+        double evaluate(E *&el)
+        {
+            std::vector<uint64_t> covered(words, 0);
+            return column_gain(covered, column(el));
+        }
+
+        std::unique_ptr<OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            std::unique_ptr<CoverageState<E>> state(new CoverageState<E>);
+            state->ground_set = V;
+            state->covered.assign(words, 0);
+            if (V)
+            {
+                // look every ground set element's entry up once, so batches can read them by id
+                state->columns.resize(V->size());
+                for (uint32_t id = 0; id < V->size(); id++)
+                {
+                    state->columns[id] = column((*V)[id]);
+                }
+            }
+            return state;
+        }
+
+        double gain(OracleState<E> *state, E *el)
+        {
+            return column_gain(static_cast<CoverageState<E> *>(state)->covered, column(el));
+        }
+
+        void gains(OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+        {
+            CoverageState<E> *coverage_state = static_cast<CoverageState<E> *>(state);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                out[i] = column_gain(coverage_state->covered, coverage_state->columns[ids[i]]);
+            }
+        }
+
+        void commit(OracleState<E> *state, E *el)
+        {
+            CoverageState<E> *coverage_state = static_cast<CoverageState<E> *>(state);
+            uint32_t j = column(el);
+            coverage_state->set.insert(el);
+            coverage_state->value = coverage_state->value + column_gain(coverage_state->covered, j);
+            cover(coverage_state->covered, j);
+        }
+
+    private:
+        uint32_t column(E *el) const
+        {
+            auto it = columns.ids.find(el);
+            return (it == columns.ids.end()) ? NO_COLUMN : it->second;
+        }
+
+        double column_gain(const std::vector<uint64_t> &covered, const uint32_t &j) const
+        {
+            // total weight of the items j covers that are not covered yet
+            if (j == NO_COLUMN)
+            {
+                return 0;
+            }
+            if (bitset_index[j] != NO_BITSET)
+            {
+                const uint64_t *row = bitsets.data() + std::size_t(bitset_index[j]) * words;
+                if (weights.empty())
+                {
+                    return double(simd::count_and_not(row, covered.data(), words));
+                }
+                double val = 0;
+                for (uint32_t w = 0; w < words; w++)
+                {
+                    for (uint64_t fresh = row[w] & ~covered[w]; fresh; fresh &= fresh - 1)
+                    {
+                        val = val + weights[(w << 6) + simd::lowest_bit(fresh)];
+                    }
+                }
+                return val;
+            }
+            double val = 0;
+            for (std::size_t k = offsets[j]; k < offsets[j + 1]; k++)
+            {
+                uint32_t item = items[k];
+                if (!((covered[item >> 6] >> (item & 63)) & 1))
+                {
+                    val = val + (weights.empty() ? 1.0 : weights[item]);
+                }
+            }
+            return val;
+        }
+
+        void cover(std::vector<uint64_t> &covered, const uint32_t &j) const
+        {
+            if (j == NO_COLUMN)
+            {
+                return;
+            }
+            if (bitset_index[j] != NO_BITSET)
+            {
+                const uint64_t *row = bitsets.data() + std::size_t(bitset_index[j]) * words;
+                for (uint32_t w = 0; w < words; w++)
+                {
+                    covered[w] |= row[w];
+                }
+                return;
+            }
+            for (std::size_t k = offsets[j]; k < offsets[j + 1]; k++)
+            {
+                covered[items[k] >> 6] |= uint64_t(1) << (items[k] & 63);
+            }
+        }
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <queue>
 #include <unordered_set>
@@ -15,4 +16,17 @@ public:
 };
 
 template <typename E>
-using LazyGreedyQueue = std::priority_queue<std::pair<E *, double>, std::vector<std::pair<E *, double>>, compare_element_value_pair<E>>;
\ No newline at end of file
+using LazyGreedyQueue = std::priority_queue<std::pair<E *, double>, std::vector<std::pair<E *, double>>, compare_element_value_pair<E>>;
+
+class compare_id_value_pair
+{
+public:
+    bool operator()(const std::pair<uint32_t, double> &lhs, const std::pair<uint32_t, double> &rhs) const
+    {
+        // orders by value, then prefers the lower ground set id, so the top of the queue is always well defined
+        return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first > rhs.first);
+    };
+};
+
+// Priority queue over dense ground set ids (see ground_set.hpp)
+using LazyGreedyIdQueue = std::priority_queue<std::pair<uint32_t, double>, std::vector<std::pair<uint32_t, double>>, compare_id_value_pair>;
@@ -0,0 +1,302 @@
+#pragma once
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "cost_function.hpp"
+#include "ground_set.hpp"
+#include "../utils/simd.hpp"
+
+namespace costfunction
+{
+    template <typename E>
+    class FacilityLocationState : public OracleState<E>
+    {
+        // best similarity any committed element achieves on each row, laid out like one column of the matrix
+    public:
+        std::vector<double> best;
+        std::vector<uint32_t> columns; // matrix column of each ground set id, or NO_COLUMN
+    };
+
+    template <typename E>
+    class FacilityLocation : public CostFunction<E>
+    {
+        /* F(S) = sum over rows i of max(0, max over j in S of sim(i, j)), over a dense similarity matrix.
+         *  Columns are the elements of a ground set, rows are whatever they should cover (often the same elements).
+         *  The matrix is stored column-major in blocks of block_rows rows, so a gain streams one contiguous
+         *  column slice against the matching slice of the state's best vector, and a batch of gains reuses each
+         *  slice of the best vector from cache across all its candidates.
+         */
+    public:
+        static constexpr uint32_t NO_COLUMN = UINT32_MAX;
+
+        groundset::GroundSet<E> columns; // element of each column
+        uint32_t rows = 0;
+        uint32_t block_rows = 0;  // rows per block, a multiple of the vector width
+        uint32_t padded_rows = 0; // rows rounded up to whole blocks, padding rows are all zero
+        std::vector<double> matrix;
+
+        FacilityLocation(const groundset::GroundSet<E> &V, const std::vector<double> &similarity, const uint32_t &num_rows, const uint32_t &max_block_rows = 1024)
+        {
+            /* similarity is row-major, num_rows by V.size(): similarity[i * V.size() + j] = sim(row i, element j).
+             */
+            columns = V;
+            rows = num_rows;
+            block_rows = round_up(std::min(std::max(max_block_rows, uint32_t(1)), std::max(rows, uint32_t(1))), simd::lanes);
+            padded_rows = round_up(rows, block_rows);
+
+            uint32_t n = columns.size();
+            matrix.assign(std::size_t(padded_rows) * n, 0);
+            for (uint32_t i = 0; i < rows; i++)
+            {
+                for (uint32_t j = 0; j < n; j++)
+                {
+                    matrix[offset(i, j)] = similarity[std::size_t(i) * n + j];
+                }
+            }
+        }
+
+        double evaluate(std::unordered_set<E *> &set)
+        {
+            std::vector<double> best(padded_rows, 0);
+            for (auto el : set)
+            {
+                if (uint32_t j = column(el); j != NO_COLUMN)
+                {
+                    max_update(best, j);
+                }
+            }
+            double val = 0;
+            for (auto b : best)
+            {
+                val = val + b;
+            }
+            return val;
+        }
+
+        double evaluate(E *&el)
+        {
+            std::vector<double> best(padded_rows, 0);
+            return column_gain(best, column(el));
+        }
+
+        std::unique_ptr<OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            std::unique_ptr<FacilityLocationState<E>> state(new FacilityLocationState<E>);
+            state->ground_set = V;
+            state->best.assign(padded_rows, 0);
+            if (V)
+            {
+                // look every ground set element's column up once, so batches can read them by id
+                state->columns.resize(V->size());
+                for (uint32_t id = 0; id < V->size(); id++)
+                {
+                    state->columns[id] = column((*V)[id]);
+                }
+            }
+            return state;
+        }
+
+        double gain(OracleState<E> *state, E *el)
+        {
+            return column_gain(static_cast<FacilityLocationState<E> *>(state)->best, column(el));
+        }
+
+        void gains(OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+        {
+            // block by block, so each slice of the best vector stays in cache while every candidate is scanned against it
+            FacilityLocationState<E> *fl_state = static_cast<FacilityLocationState<E> *>(state);
+            std::fill(out, out + count, 0.0);
+            for (uint32_t start = 0; start < padded_rows; start += block_rows)
+            {
+                const double *best = fl_state->best.data() + start;
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    if (uint32_t j = fl_state->columns[ids[i]]; j != NO_COLUMN)
+                    {
+                        out[i] = out[i] + simd::sum_positive_difference(matrix.data() + offset(start, j), best, block_rows);
+                    }
+                }
+            }
+        }
+
+        void commit(OracleState<E> *state, E *el)
+        {
+            FacilityLocationState<E> *fl_state = static_cast<FacilityLocationState<E> *>(state);
+            uint32_t j = column(el);
+            fl_state->set.insert(el);
+            fl_state->value = fl_state->value + column_gain(fl_state->best, j);
+            if (j != NO_COLUMN)
+            {
+                max_update(fl_state->best, j);
+            }
+        }
+
+    private:
+        static uint32_t round_up(const uint32_t &x, const std::size_t &multiple)
+        {
+            return uint32_t((x + multiple - 1) / multiple * multiple);
+        }
+
+        std::size_t offset(const uint32_t &row, const uint32_t &col) const
+        {
+            // block of the row, then column within the block, then row within the column slice
+            uint32_t block = row / block_rows;
+            return (std::size_t(block) * columns.size() + col) * block_rows + row % block_rows;
+        }
+
+        uint32_t column(E *el) const
+        {
+            auto it = columns.ids.find(el);
+            return (it == columns.ids.end()) ? NO_COLUMN : it->second;
+        }
+
+        double column_gain(const std::vector<double> &best, const uint32_t &j) const
+        {
+            // sum of max(sim(i, j) - best[i], 0), block by block in the same order as gains
+            double val = 0;
+            if (j == NO_COLUMN)
+            {
+                return val;
+            }
+            for (uint32_t start = 0; start < padded_rows; start += block_rows)
+            {
+                val = val + simd::sum_positive_difference(matrix.data() + offset(start, j), best.data() + start, block_rows);
+            }
+            return val;
+        }
+
+        void max_update(std::vector<double> &best, const uint32_t &j) const
+        {
+            for (uint32_t start = 0; start < padded_rows; start += block_rows)
+            {
+                simd::max_update(best.data() + start, matrix.data() + offset(start, j), block_rows);
+            }
+        }
+    };
+
+    template <typename E>
+    class SparseFacilityLocation : public CostFunction<E>
+    {
+        /* The same F(S) = sum over rows i of max(0, max over j in S of sim(i, j)), over a sparse similarity graph,
+         *  typically each element's k nearest neighbours. Column j of the matrix is stored CSR-style as the rows it
+         *  covers (offsets[j] to offsets[j + 1] in neighbors/similarities), so memory is O(nnz) and a gain only walks
+         *  the candidate's own adjacency list. Rows missing from a column have similarity 0.
+         */
+    public:
+        static constexpr uint32_t NO_COLUMN = UINT32_MAX;
+
+        groundset::GroundSet<E> columns; // element of each column
+        uint32_t rows = 0;
+        std::vector<std::size_t> offsets; // columns.size() + 1 entries
+        std::vector<uint32_t> neighbors;  // row of each nonzero
+        std::vector<double> similarities; // value of each nonzero
+
+        SparseFacilityLocation(const groundset::GroundSet<E> &V, const std::vector<std::size_t> &column_offsets, const std::vector<uint32_t> &column_rows, const std::vector<double> &column_similarities, const uint32_t &num_rows)
+        {
+            columns = V;
+            rows = num_rows;
+            offsets = column_offsets;
+            neighbors = column_rows;
+            similarities = column_similarities;
+        }
+
+        double evaluate(std::unordered_set<E *> &set)
+        {
+            std::vector<double> best(rows, 0);
+            for (auto el : set)
+            {
+                if (uint32_t j = column(el); j != NO_COLUMN)
+                {
+                    max_update(best, j);
+                }
+            }
+            double val = 0;
+            for (auto b : best)
+            {
+                val = val + b;
+            }
+            return val;
+        }
+
+        double evaluate(E *&el)
+        {
+            std::vector<double> best(rows, 0);
+            return column_gain(best, column(el));
+        }
+
+        std::unique_ptr<OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            std::unique_ptr<FacilityLocationState<E>> state(new FacilityLocationState<E>);
+            state->ground_set = V;
+            state->best.assign(rows, 0);
+            if (V)
+            {
+                // look every ground set element's column up once, so batches can read them by id
+                state->columns.resize(V->size());
+                for (uint32_t id = 0; id < V->size(); id++)
+                {
+                    state->columns[id] = column((*V)[id]);
+                }
+            }
+            return state;
+        }
+
+        double gain(OracleState<E> *state, E *el)
+        {
+            return column_gain(static_cast<FacilityLocationState<E> *>(state)->best, column(el));
+        }
+
+        void gains(OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+        {
+            FacilityLocationState<E> *fl_state = static_cast<FacilityLocationState<E> *>(state);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                out[i] = column_gain(fl_state->best, fl_state->columns[ids[i]]);
+            }
+        }
+
+        void commit(OracleState<E> *state, E *el)
+        {
+            FacilityLocationState<E> *fl_state = static_cast<FacilityLocationState<E> *>(state);
+            uint32_t j = column(el);
+            fl_state->set.insert(el);
+            fl_state->value = fl_state->value + column_gain(fl_state->best, j);
+            if (j != NO_COLUMN)
+            {
+                max_update(fl_state->best, j);
+            }
+        }
+
+    private:
+        uint32_t column(E *el) const
+        {
+            auto it = columns.ids.find(el);
+            return (it == columns.ids.end()) ? NO_COLUMN : it->second;
+        }
+
+        double column_gain(const std::vector<double> &best, const uint32_t &j) const
+        {
+            // sum of max(sim(i, j) - best[i], 0) over the rows j covers
+            double val = 0;
+            if (j == NO_COLUMN)
+            {
+                return val;
+            }
+            for (std::size_t k = offsets[j]; k < offsets[j + 1]; k++)
+            {
+                val = val + simd::max(similarities[k] - best[neighbors[k]], 0.0);
+            }
+            return val;
+        }
+
+        void max_update(std::vector<double> &best, const uint32_t &j) const
+        {
+            for (std::size_t k = offsets[j]; k < offsets[j + 1]; k++)
+            {
+                best[neighbors[k]] = simd::max(similarities[k], best[neighbors[k]]);
+            }
+        }
+    };
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace groundset
+{
+    template <typename E>
+    class GroundSet
+    {
+        // Dense view of a ground set: elements are numbered 0 to n-1 in insertion order,
+        // so optimizers can index flat arrays by id instead of hashing pointers in their inner loops.
+    public:
+        std::vector<E *> elements;             // maps an id to its element
+        std::unordered_map<E *, uint32_t> ids; // maps an element to its id, only needed at the boundaries
+
+        GroundSet() {}
+
+        GroundSet(const std::unordered_set<E *> &V)
+        {
+            elements.reserve(V.size());
+            ids.reserve(V.size());
+            for (auto el : V)
+            {
+                this->insert(el);
+            }
+        }
+
+        uint32_t insert(E *el)
+        {
+            // returns the id of el, numbering it if it is new
+            auto [it, inserted] = ids.insert({el, uint32_t(elements.size())});
+            if (inserted)
+            {
+                elements.push_back(el);
+            }
+            return it->second;
+        }
+
+        bool contains(E *el) const
+        {
+            return ids.find(el) != ids.end();
+        }
+
+        uint32_t id(E *el) const
+        {
+            // el must be in the ground set
+            return ids.find(el)->second;
+        }
+
+        E *operator[](const uint32_t &id) const
+        {
+            return elements[id];
+        }
+
+        uint32_t size() const
+        {
+            return uint32_t(elements.size());
+        }
+
+        std::unordered_set<E *> to_set() const
+        {
+            return std::unordered_set<E *>(elements.begin(), elements.end());
+        }
+    };
+
+    class Membership
+    {
+        // Dense bitset over ground set ids, used to mark the elements of a solution (or any other subset).
+    public:
+        std::vector<uint64_t> words;
+        uint32_t count = 0; // number of ids currently in the set
+
+        Membership() {}
+
+        Membership(const uint32_t &n)
+        {
+            this->resize(n);
+        }
+
+        void resize(const uint32_t &n)
+        {
+            // holds ids 0 to n-1, and empties the set
+            words.assign((n + 63) / 64, 0);
+            count = 0;
+        }
+
+        void clear()
+        {
+            std::fill(words.begin(), words.end(), 0);
+            count = 0;
+        }
+
+        bool contains(const uint32_t &id) const
+        {
+            return (words[id >> 6] >> (id & 63)) & 1;
+        }
+
+        void insert(const uint32_t &id)
+        {
+            if (!this->contains(id))
+            {
+                words[id >> 6] |= uint64_t(1) << (id & 63);
+                count++;
+            }
+        }
+
+        void erase(const uint32_t &id)
+        {
+            if (this->contains(id))
+            {
+                words[id >> 6] &= ~(uint64_t(1) << (id & 63));
+                count--;
+            }
+        }
+
+        uint32_t size() const
+        {
+            return count;
+        }
+    };
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <unordered_set>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include "cost_function.hpp"
+#include "ground_set.hpp"
+
+namespace costfunction
+{
+    template <typename E>
+    class LogDetState : public OracleState<E>
+    {
+        // Cholesky factor of I + L restricted to the committed elements, in commit order
+    public:
+        std::vector<uint32_t> selected; // kernel index of each committed element
+        std::vector<double> factor;     // lower triangular rows, row i holds i + 1 entries starting at i(i+1)/2
+        std::vector<uint32_t> columns;  // kernel index of each ground set id, or NO_COLUMN
+
+        // batch path only: each id's forward substitution so far, extended by the rows committed since
+        std::vector<std::vector<double>> solved;
+    };
+
+    template <typename E>
+    class LogDet : public CostFunction<E>
+    {
+        /* F(S) = log det(I + L_S) for a positive semidefinite kernel L over the elements of a ground set,
+         *  which rewards sets of dissimilar elements (the MAP objective of a determinantal point process).
+         *  The state keeps the Cholesky factor R of I + L_S. Adding j extends it by the row (c, d), with
+         *  R c = L_{S,j} and d^2 = 1 + L_jj - c.c, so a gain is log(d^2): one O(|S|^2) triangular solve, and a
+         *  commit appends that row. Batched gains also keep each candidate's c between calls, since earlier rows
+         *  of R never change, and only solve for the rows committed since, which is what keeps lazy greedy cheap.
+         */
+    public:
+        static constexpr uint32_t NO_COLUMN = UINT32_MAX;
+
+        groundset::GroundSet<E> columns; // element of each kernel row/column
+        std::vector<double> kernel;      // row-major, columns.size() squared
+
+        LogDet(const groundset::GroundSet<E> &V, const std::vector<double> &L)
+        {
+            columns = V;
+            kernel = L;
+        }
+
+        double evaluate(std::unordered_set<E *> &set)
+        {
+            LogDetState<E> state;
+            for (auto el : set)
+            {
+                this->extend(&state, column(el));
+            }
+            return state.value;
+        }
+
+        double evaluate(E *&el)
+        {
+            uint32_t j = column(el);
+            return (j == NO_COLUMN) ? 0 : std::log(1 + entry(j, j));
+        }
+
+        std::unique_ptr<OracleState<E>> new_state(groundset::GroundSet<E> *V = nullptr)
+        {
+            std::unique_ptr<LogDetState<E>> state(new LogDetState<E>);
+            state->ground_set = V;
+            if (V)
+            {
+                // look every ground set element's kernel index up once, so batches can read them by id
+                state->columns.resize(V->size());
+                state->solved.resize(V->size());
+                for (uint32_t id = 0; id < V->size(); id++)
+                {
+                    state->columns[id] = column((*V)[id]);
+                }
+            }
+            return state;
+        }
+
+        double gain(OracleState<E> *state, E *el)
+        {
+            LogDetState<E> *ld_state = static_cast<LogDetState<E> *>(state);
+            std::vector<double> c;
+            return std::log(schur_complement(ld_state, column(el), c));
+        }
+
+        void gains(OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+        {
+            /* Each id's cached solve is only touched by the call evaluating that id, so batches of distinct ids
+             *  can be evaluated concurrently.
+             */
+            LogDetState<E> *ld_state = static_cast<LogDetState<E> *>(state);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                out[i] = std::log(schur_complement(ld_state, ld_state->columns[ids[i]], ld_state->solved[ids[i]]));
+            }
+        }
+
+        void commit(OracleState<E> *state, E *el)
+        {
+            LogDetState<E> *ld_state = static_cast<LogDetState<E> *>(state);
+            ld_state->set.insert(el);
+            this->extend(ld_state, column(el));
+        }
+
+    private:
+        uint32_t column(E *el) const
+        {
+            auto it = columns.ids.find(el);
+            return (it == columns.ids.end()) ? NO_COLUMN : it->second;
+        }
+
+        double entry(const uint32_t &i, const uint32_t &j) const
+        {
+            return kernel[std::size_t(i) * columns.size() + j];
+        }
+
+        double schur_complement(const LogDetState<E> *state, const uint32_t &j, std::vector<double> &c) const
+        {
+            /* Solves R c = L_{S,j} by forward substitution, starting from the entries already in c,
+             *  and returns d^2 = 1 + L_jj - c.c (1 for elements outside the kernel, which add nothing).
+             */
+            if (j == NO_COLUMN)
+            {
+                return 1;
+            }
+            std::size_t m = state->selected.size();
+            for (std::size_t i = c.size(); i < m; i++)
+            {
+                const double *row = state->factor.data() + i * (i + 1) / 2;
+                double sum = entry(state->selected[i], j);
+                for (std::size_t k = 0; k < i; k++)
+                {
+                    sum = sum - row[k] * c[k];
+                }
+                c.push_back(sum / row[i]);
+            }
+            double d2 = 1 + entry(j, j);
+            for (std::size_t k = 0; k < m; k++)
+            {
+                d2 = d2 - c[k] * c[k];
+            }
+            return d2;
+        }
+
+        void extend(LogDetState<E> *state, const uint32_t &j) const
+        {
+            // rank-1 extension of the factor by the row (c, d)
+            if (j == NO_COLUMN)
+            {
+                return;
+            }
+            std::vector<double> c;
+            double d2 = schur_complement(state, j, c);
+            state->factor.insert(state->factor.end(), c.begin(), c.end());
+            state->factor.push_back(std::sqrt(d2));
+            state->selected.push_back(j);
+            state->value = state->value + std::log(d2);
+        }
+    };
+}
@@ -0,0 +1,199 @@
+// Concepts and call helpers for optimizers templated on their concrete cost function and constraint types.
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include "cost_function.hpp"
+#include "constraint.hpp"
+#include "ground_set.hpp"
+
+namespace dispatch
+{
+    template <typename F, typename E>
+    concept IncrementalCostFunction = requires(F &f, costfunction::OracleState<E> *state, E *el, groundset::GroundSet<E> *V,
+                                               const uint32_t *ids, std::size_t count, double *out) {
+        // the stateful oracle the optimizers use, see CostFunction
+        { f.new_state(V) } -> std::convertible_to<std::unique_ptr<costfunction::OracleState<E>>>;
+        { f.gain(state, el) } -> std::convertible_to<double>;
+        f.gains(state, ids, count, out);
+        f.commit(state, el);
+    };
+
+    template <typename C, typename E>
+    concept StatefulConstraint = requires(C &c, constraint::ConstraintState<E> *state, E *el) {
+        // the stateful feasibility checks the optimizers use, see Constraint
+        { c.new_state() } -> std::convertible_to<std::unique_ptr<constraint::ConstraintState<E>>>;
+        { c.can_add(state, el) } -> std::convertible_to<bool>;
+        c.commit(state, el);
+        { c.saturated(state) } -> std::convertible_to<bool>;
+    };
+
+    template <typename C, typename E>
+    concept KnapsackConstraint = StatefulConstraint<C, E> && std::derived_from<C, constraint::Knapsack<E>>;
+
+    /* The helpers below call T's own implementation directly (a qualified call, which the compiler can inline),
+     *  so the object must not be of a class derived from T that overrides it. Abstract types such as
+     *  CostFunction<E> or Constraint<E> have nothing to call directly, so they keep the virtual call.
+     */
+
+    template <typename T, typename E>
+    std::unique_ptr<costfunction::OracleState<E>> new_state(T &F, groundset::GroundSet<E> *V)
+    {
+        if constexpr (std::is_abstract_v<T>)
+        {
+            return F.new_state(V);
+        }
+        else
+        {
+            return F.T::new_state(V);
+        }
+    }
+
+    template <typename T, typename E>
+    double gain(T &F, costfunction::OracleState<E> *state, E *el)
+    {
+        if constexpr (std::is_abstract_v<T>)
+        {
+            return F.gain(state, el);
+        }
+        else
+        {
+            return F.T::gain(state, el);
+        }
+    }
+
+    template <typename T, typename E>
+    void gains(T &F, costfunction::OracleState<E> *state, const uint32_t *ids, std::size_t count, double *out)
+    {
+        if constexpr (std::is_abstract_v<T>)
+        {
+            F.gains(state, ids, count, out);
+        }
+        else
+        {
+            F.T::gains(state, ids, count, out);
+        }
+    }
+
+    template <typename T, typename E>
+    void commit(T &F, costfunction::OracleState<E> *state, E *el)
+    {
+        if constexpr (std::is_abstract_v<T>)
+        {
+            F.commit(state, el);
+        }
+        else
+        {
+            F.T::commit(state, el);
+        }
+    }
+
+    template <typename E, typename T>
+    std::unique_ptr<constraint::ConstraintState<E>> constraint_state(T &C)
+    {
+        // C's state for an empty solution, called as constraint_state<E>(C)
+        if constexpr (std::is_abstract_v<T>)
+        {
+            return C.new_state();
+        }
+        else
+        {
+            return C.T::new_state();
+        }
+    }
+
+    template <typename T, typename E>
+    bool can_add(T &C, constraint::ConstraintState<E> *state, E *el)
+    {
+        if constexpr (std::is_abstract_v<T>)
+        {
+            return C.can_add(state, el);
+        }
+        else
+        {
+            return C.T::can_add(state, el);
+        }
+    }
+
+    template <typename T, typename E>
+    bool can_add(T &C, constraint::ConstraintState<E> *state, E *el, uint64_t &checks)
+    {
+        // as can_add, counting the checks: one, or one per member asked for a constraint that counts its own
+        if constexpr (requires { { C.can_add(state, el, checks) } -> std::convertible_to<bool>; })
+        {
+            if constexpr (std::is_abstract_v<T>)
+            {
+                return C.can_add(state, el, checks);
+            }
+            else
+            {
+                return C.T::can_add(state, el, checks);
+            }
+        }
+        else
+        {
+            checks++;
+            return dispatch::can_add(C, state, el);
+        }
+    }
+
+    template <typename T, typename E>
+    void commit(T &C, constraint::ConstraintState<E> *state, E *el)
+    {
+        if constexpr (std::is_abstract_v<T>)
+        {
+            C.commit(state, el);
+        }
+        else
+        {
+            C.T::commit(state, el);
+        }
+    }
+
+    template <typename T, typename E>
+    bool saturated(T &C, constraint::ConstraintState<E> *state)
+    {
+        if constexpr (std::is_abstract_v<T>)
+        {
+            return C.saturated(state);
+        }
+        else
+        {
+            return C.T::saturated(state);
+        }
+    }
+
+    template <typename T, typename E, typename Fn>
+    void for_each_constraint(T &C, constraint::ConstraintState<E> *state, Fn fn)
+    {
+        // fn(constraint, its running state) for C, or for each of its members if C is an intersection of others
+        if constexpr (requires { C.for_each_member(state, fn); })
+        {
+            C.for_each_member(state, fn);
+        }
+        else
+        {
+            fn(&C, state);
+        }
+    }
+
+    template <typename Target, typename T>
+    Target *cast(T *C)
+    {
+        // C as a Target: directly when T is one, by dynamic_cast when T is a base of Target, otherwise nullptr
+        if constexpr (std::derived_from<T, Target>)
+        {
+            return C;
+        }
+        else if constexpr (std::derived_from<Target, T>)
+        {
+            return dynamic_cast<Target *>(C);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+}
@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+// include the cost function and constraint interfaces
+#include "sfo_cpp/sfo_concepts/cost_function.hpp"
+#include "sfo_cpp/sfo_concepts/constraint.hpp"
+#include "sfo_cpp/sfo_concepts/facility_location.hpp"
+#include "sfo_cpp/sfo_concepts/coverage.hpp"
+#include "sfo_cpp/sfo_concepts/log_det.hpp"
+#include "sfo_cpp/sfo_concepts/cached_cost.hpp"
+
+// Elements are templated out, include a basic "element" class for testing
+#include "sfo_cpp/tests/test_utils/demo_element.hpp"
+
+// Convenience fixtures for testing various cost functions
+#include "sfo_cpp/tests/test_utils/test_fixtures.hpp"
+
+// Cost function that only implements evaluate, so it exercises the default (copying) oracle.
+class EvaluateOnlyCost : public costfunction::CostFunction<Element>
+{
+public:
+    costfunction::Modular<Element> modular_part;
+
+    EvaluateOnlyCost(const costfunction::Modular<Element> &m) : modular_part(m) {}
+
+    double evaluate(std::unordered_set<Element *> &set)
+    {
+        return std::log(1 + modular_part.evaluate(set));
+    }
+
+    double evaluate(Element *&el)
+    {
+        return std::log(1 + modular_part.evaluate(el));
+    }
+};
+
+// Commits every element of the ground set one at a time, checking gain, gains and value against evaluate.
+void expect_oracle_matches_evaluate(costfunction::CostFunction<Element> *F, std::unordered_set<Element *> *V)
+{
+    groundset::GroundSet<Element> dense_ground_set(*V);
+    std::unique_ptr<costfunction::OracleState<Element>> state = F->new_state(&dense_ground_set);
+    std::unordered_set<Element *> reference;
+    EXPECT_FLOAT_EQ(state->value, F->evaluate(reference));
+
+    std::vector<uint32_t> ids(dense_ground_set.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    std::vector<double> batch_gains(ids.size());
+
+    for (auto el : *V)
+    {
+        double expected_gain = F->marginal_gain(el, reference);
+        EXPECT_FLOAT_EQ(F->gain(state.get(), el), expected_gain) << "Element: " << *el;
+
+        // the batch oracle should agree with the scalar one on every remaining candidate
+        ids.erase(std::find(ids.begin(), ids.end(), dense_ground_set.id(el)));
+        F->gains(state.get(), ids.data(), ids.size(), batch_gains.data());
+        for (std::size_t i = 0; i < ids.size(); i++)
+        {
+            EXPECT_FLOAT_EQ(batch_gains[i], F->gain(state.get(), dense_ground_set[ids[i]])) << "Element: " << *dense_ground_set[ids[i]];
+        }
+
+        F->commit(state.get(), el);
+        reference.insert(el);
+        EXPECT_FLOAT_EQ(state->value, F->evaluate(reference)) << "Element: " << *el;
+        EXPECT_EQ(state->set, reference);
+    }
+}
+
+TEST_F(ConstrainedModularCost, ModularOracleTest)
+{
+    expect_oracle_matches_evaluate(cost_function, ground_set);
+}
+
+TEST_F(SqrtModularCost, SqrtModularOracleTest)
+{
+    expect_oracle_matches_evaluate(cost_function, ground_set);
+}
+
+TEST_F(SqrtModularCost, CenteredSqrtModularOracleTest)
+{
+    costfunction::CenteredSqrtModular<Element> centered(modular, 50, 100);
+    expect_oracle_matches_evaluate(&centered, ground_set);
+}
+
+TEST_F(SqrtModularCost, DefaultOracleTest)
+{
+    EvaluateOnlyCost log_modular(modular);
+    expect_oracle_matches_evaluate(&log_modular, ground_set);
+}
+
+TEST_F(SqrtModularCost, CachedOracleTest)
+{
+    // The cache answers exactly what the wrapped oracle would, including the default (copying) one.
+    EvaluateOnlyCost log_modular(modular);
+    costfunction::CachedCostFunction<Element> cached(&log_modular, 64);
+    expect_oracle_matches_evaluate(&cached, ground_set);
+    EXPECT_GT(cached.hits(), 0);
+    EXPECT_EQ(cached.cache.capacity(), 64);
+
+    // Sets are hashed by content, however they were built.
+    std::unordered_set<Element *> set(ground_set->begin(), ground_set->end());
+    cached.cache.clear();
+    double value = cached.evaluate(set);
+    std::unordered_set<Element *> copy;
+    for (auto el : set)
+    {
+        copy.insert(el);
+    }
+    EXPECT_EQ(cached.evaluate(copy), value);
+    EXPECT_EQ(cached.misses(), 1);
+    EXPECT_EQ(cached.hits(), 1);
+
+    // A table far smaller than the working set evicts entries, and still answers correctly.
+    costfunction::CachedCostFunction<Element> small(&log_modular, 8);
+    expect_oracle_matches_evaluate(&small, ground_set);
+}
+
+TEST(FacilityLocationCost, FacilityLocationOracleTest)
+{
+    // An odd number of rows and tiny blocks, so padding and several blocks are both exercised.
+    int set_size = 12;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    uint32_t rows = 37;
+    std::vector<double> similarity(rows * V.size());
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        for (uint32_t j = 0; j < V.size(); j++)
+        {
+            similarity[i * V.size() + j] = std::sin(0.7 * i + 1.3 * j) + 0.25;
+        }
+    }
+
+    costfunction::FacilityLocation<Element> facility_location(V, similarity, rows, 5);
+    std::unordered_set<Element *> ground_set = V.to_set();
+    expect_oracle_matches_evaluate(&facility_location, &ground_set);
+
+    // Each row is covered by its best element, negative similarities count as zero.
+    double expected = 0;
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        expected = expected + std::max(0.0, *std::max_element(similarity.begin() + i * V.size(), similarity.begin() + (i + 1) * V.size()));
+    }
+    EXPECT_FLOAT_EQ(facility_location.evaluate(ground_set), expected);
+}
+
+TEST(FacilityLocationCost, SparseFacilityLocationOracleTest)
+{
+    // Keep each element's 4 most similar rows, and check against the dense version of the same (sparsified) matrix.
+    int set_size = 12;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    uint32_t rows = 20;
+    std::vector<double> dense_similarity(rows * V.size(), 0);
+    std::vector<std::size_t> offsets = {0};
+    std::vector<uint32_t> neighbors;
+    std::vector<double> similarities;
+    for (uint32_t j = 0; j < V.size(); j++)
+    {
+        std::vector<uint32_t> order(rows);
+        std::iota(order.begin(), order.end(), 0);
+        auto sim = [&](uint32_t i)
+        { return std::cos(0.9 * i + 2.1 * j); };
+        std::partial_sort(order.begin(), order.begin() + 4, order.end(), [&](uint32_t a, uint32_t b)
+                          { return sim(a) > sim(b); });
+        for (int k = 0; k < 4; k++)
+        {
+            neighbors.push_back(order[k]);
+            similarities.push_back(sim(order[k]));
+            dense_similarity[order[k] * V.size() + j] = sim(order[k]);
+        }
+        offsets.push_back(neighbors.size());
+    }
+
+    costfunction::SparseFacilityLocation<Element> sparse(V, offsets, neighbors, similarities, rows);
+    costfunction::FacilityLocation<Element> dense(V, dense_similarity, rows);
+    std::unordered_set<Element *> ground_set = V.to_set();
+    expect_oracle_matches_evaluate(&sparse, &ground_set);
+
+    std::unordered_set<Element *> subset;
+    for (uint32_t id = 0; id < V.size(); id += 3)
+    {
+        subset.insert(V[id]);
+        EXPECT_FLOAT_EQ(sparse.evaluate(subset), dense.evaluate(subset));
+    }
+}
+
+TEST(WeightedCoverageCost, WeightedCoverageOracleTest)
+{
+    // Even elements cover many items (bitsets), odd elements a few (sorted lists), with overlaps between them.
+    int set_size = 12;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    uint32_t universe = 200;
+    std::vector<std::vector<uint32_t>> covers(V.size());
+    for (uint32_t j = 0; j < V.size(); j++)
+    {
+        int num_items = (j % 2 == 0) ? 60 : 5;
+        for (int k = 0; k < num_items; k++)
+        {
+            covers[j].push_back((j * 17 + k * 3) % universe);
+        }
+    }
+    std::vector<double> weights(universe);
+    for (uint32_t item = 0; item < universe; item++)
+    {
+        weights[item] = 1 + (item % 5) * 0.5;
+    }
+
+    costfunction::WeightedCoverage<Element> coverage(V, covers, universe);
+    costfunction::WeightedCoverage<Element> weighted_coverage(V, covers, universe, weights);
+    EXPECT_NE(coverage.bitset_index[0], coverage.NO_BITSET);
+    EXPECT_EQ(coverage.bitset_index[1], coverage.NO_BITSET);
+
+    std::unordered_set<Element *> ground_set = V.to_set();
+    expect_oracle_matches_evaluate(&coverage, &ground_set);
+    expect_oracle_matches_evaluate(&weighted_coverage, &ground_set);
+
+    // The whole ground set covers the union of all items.
+    std::unordered_set<uint32_t> covered_items;
+    double covered_weight = 0;
+    for (auto &list : covers)
+    {
+        for (auto item : list)
+        {
+            if (covered_items.insert(item).second)
+            {
+                covered_weight = covered_weight + weights[item];
+            }
+        }
+    }
+    EXPECT_FLOAT_EQ(coverage.evaluate(ground_set), covered_items.size());
+    EXPECT_FLOAT_EQ(weighted_coverage.evaluate(ground_set), covered_weight);
+}
+
+TEST(LogDetCost, LogDetOracleTest)
+{
+    // Gaussian kernel over points on a line, which is positive definite.
+    int set_size = 12;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    std::vector<double> kernel(V.size() * V.size());
+    for (uint32_t i = 0; i < V.size(); i++)
+    {
+        for (uint32_t j = 0; j < V.size(); j++)
+        {
+            double distance = 0.4 * (double(i) - double(j));
+            kernel[i * V.size() + j] = 2 * std::exp(-distance * distance);
+        }
+    }
+
+    costfunction::LogDet<Element> log_det(V, kernel);
+    std::unordered_set<Element *> ground_set = V.to_set();
+    expect_oracle_matches_evaluate(&log_det, &ground_set);
+
+    // Two elements: det(I + L_S) = (1 + L_00)(1 + L_11) - L_01^2.
+    std::unordered_set<Element *> pair = {V[0], V[1]};
+    double expected = std::log((1 + kernel[0]) * (1 + kernel[V.size() + 1]) - kernel[1] * kernel[1]);
+    EXPECT_FLOAT_EQ(log_det.evaluate(pair), expected);
+}
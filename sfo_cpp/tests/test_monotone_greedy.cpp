@@ -1,18 +1,28 @@
 #include <gtest/gtest.h>
 
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <numeric>
 #include <algorithm>
+#include <random>
 
 // include the algorithms we want
 #include "sfo_cpp/optimizers/monotone/vanilla_greedy.hpp"
 #include "sfo_cpp/optimizers/monotone/lazy_greedy.hpp"
 #include "sfo_cpp/optimizers/monotone/stochastic_greedy.hpp"
 #include "sfo_cpp/optimizers/monotone/lazier_than_lazy_greedy.hpp"
+#include "sfo_cpp/optimizers/monotone/threshold_greedy.hpp"
+#include "sfo_cpp/optimizers/monotone/greedi.hpp"
+#include "sfo_cpp/optimizers/monotone/static_greedy.hpp"
 
 // include the cost function and constraint interfaces
+#include "sfo_cpp/sfo_concepts/ground_set.hpp"
 #include "sfo_cpp/sfo_concepts/cost_function.hpp"
+#include "sfo_cpp/sfo_concepts/facility_location.hpp"
+#include "sfo_cpp/sfo_concepts/log_det.hpp"
+#include "sfo_cpp/sfo_concepts/cached_cost.hpp"
 #include "sfo_cpp/sfo_concepts/constraint.hpp"
 
 // Elements are templated out, include a basic "element" class for testing
@@ -63,6 +73,51 @@ TEST_F(ConstrainedModularCost, VanillaGreedyCostBenefitTest)
     EXPECT_EQ(greedy.curr_set, optimal_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
 }
 
+TEST_F(ConstrainedModularCost, VanillaGreedyParallelTest)
+{
+    // A uniform cost makes every candidate tie, so this also checks that ties break the same way in parallel.
+    costfunction::Modular<Element> uniform_cost(1.0);
+    std::unordered_set<Element *> serial_set;
+
+    for (int threads : {1, 2, 3, 8})
+    {
+        VanillaGreedy<Element> greedy;
+
+        greedy.set_ground_set(ground_set);
+        greedy.add_constraint(cardinality_constraint);
+        greedy.set_cost_function(&uniform_cost);
+        greedy.set_num_threads(threads);
+
+        greedy.run_greedy();
+
+        EXPECT_TRUE(greedy.constraint_saturated);
+        EXPECT_EQ(greedy.curr_set.size(), budget);
+        EXPECT_FLOAT_EQ(greedy.curr_val, budget);
+        if (threads == 1)
+        {
+            serial_set = greedy.curr_set;
+        }
+        EXPECT_EQ(greedy.curr_set, serial_set) << "Threads: " << threads << " Optimizer set: " << greedy.curr_set << " Serial: " << serial_set;
+    }
+}
+
+TEST_F(ConstrainedModularCost, VanillaGreedyParallelCostBenefitTest)
+{
+    VanillaGreedy<Element> greedy;
+
+    greedy.set_ground_set(ground_set);
+    greedy.add_constraint(cardinality_constraint);
+    greedy.set_cost_function(cost_function);
+    greedy.set_cost_benefit(true);
+    greedy.set_num_threads(4);
+
+    greedy.run_greedy();
+
+    EXPECT_TRUE(greedy.constraint_saturated);
+    EXPECT_FLOAT_EQ(greedy.curr_val, optimal_value) << "Optimizer result: " << greedy.curr_val << " Optimal: " << optimal_value;
+    EXPECT_EQ(greedy.curr_set, optimal_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
+}
+
 TEST_F(ConstrainedModularCost, LazyGreedyTest)
 {
     // Create an algorithm object.
@@ -107,6 +162,386 @@ TEST_F(ConstrainedModularCost, LazyGreedyCostBenefitTest)
     EXPECT_EQ(greedy.curr_set, optimal_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
 }
 
+TEST_F(ConstrainedModularCost, LazyGreedyDenseGroundSetTest)
+{
+    // Number the ground set once and hand the dense version to the algorithm.
+    groundset::GroundSet<Element> dense_ground_set(*ground_set);
+    EXPECT_EQ(dense_ground_set.size(), set_size);
+    for (uint32_t id = 0; id < dense_ground_set.size(); id++)
+    {
+        EXPECT_EQ(dense_ground_set.id(dense_ground_set[id]), id);
+    }
+
+    LazyGreedy<Element> greedy;
+
+    greedy.set_ground_set(&dense_ground_set);
+    greedy.add_constraint(cardinality_constraint);
+    greedy.set_cost_function(cost_function);
+
+    greedy.run_greedy();
+
+    // Constraint should be saturated.
+    EXPECT_TRUE(greedy.constraint_saturated);
+    EXPECT_EQ(greedy.curr_set.size(), budget);
+
+    // We should have the optimal cost, since the cost function is modular.
+    EXPECT_FLOAT_EQ(greedy.curr_val, optimal_value) << "Optimizer result: " << greedy.curr_val << " Optimal: " << optimal_value;
+    EXPECT_EQ(greedy.curr_set, optimal_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
+}
+
+TEST_F(ConstrainedModularCost, LazyGreedyParallelTest)
+{
+    // A uniform cost makes every candidate tie, so batched re-evaluation must still break ties like vanilla greedy.
+    costfunction::Modular<Element> uniform_cost(1.0);
+    groundset::GroundSet<Element> dense_ground_set(*ground_set);
+
+    VanillaGreedy<Element> vanilla;
+    vanilla.set_ground_set(&dense_ground_set);
+    vanilla.add_constraint(cardinality_constraint);
+    vanilla.set_cost_function(&uniform_cost);
+    vanilla.run_greedy();
+
+    for (int threads : {1, 2, 8})
+    {
+        for (uint32_t batch : {1, 3, 16})
+        {
+            LazyGreedy<Element> greedy;
+
+            greedy.set_ground_set(&dense_ground_set);
+            greedy.add_constraint(cardinality_constraint);
+            greedy.set_cost_function(&uniform_cost);
+            greedy.set_num_threads(threads);
+            greedy.set_reevaluation_batch(batch);
+
+            greedy.run_greedy();
+
+            EXPECT_TRUE(greedy.constraint_saturated);
+            EXPECT_FLOAT_EQ(greedy.curr_val, budget);
+            EXPECT_EQ(greedy.curr_set, vanilla.curr_set) << "Threads: " << threads << " Batch: " << batch << " Optimizer set: " << greedy.curr_set << " Vanilla: " << vanilla.curr_set;
+        }
+    }
+}
+
+TEST_F(ConstrainedModularCost, OptimizerStatsTest)
+{
+    // Vanilla greedy evaluates every remaining candidate once per step, whatever the thread count.
+    for (int threads : {1, 3})
+    {
+        VanillaGreedy<Element> vanilla;
+        vanilla.set_ground_set(ground_set);
+        vanilla.add_constraint(cardinality_constraint);
+        vanilla.set_cost_function(cost_function);
+        vanilla.set_num_threads(threads);
+        vanilla.run_greedy();
+
+        const telemetry::OptimizerStats &stats = vanilla.stats();
+        EXPECT_EQ(stats.oracle_evaluations, 10 + 9 + 8) << "Threads: " << threads;
+        EXPECT_EQ(stats.constraint_checks, 10 + 9 + 8) << "Threads: " << threads;
+        ASSERT_EQ(stats.iterations.size(), budget);
+        double total_gain = 0;
+        for (auto &iteration : stats.iterations)
+        {
+            EXPECT_GE(iteration.seconds, 0);
+            total_gain = total_gain + iteration.gain;
+        }
+        EXPECT_FLOAT_EQ(total_gain, vanilla.curr_val);
+    }
+
+    // Lazy greedy needs fewer evaluations, every pop is a selection, and re-evaluations update entries in place.
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(ground_set);
+    lazy.add_constraint(cardinality_constraint);
+    lazy.set_cost_function(cost_function);
+    lazy.run_greedy();
+
+    telemetry::OptimizerStats stats = lazy.stats();
+    EXPECT_LT(stats.oracle_evaluations, 10 + 9 + 8);
+    EXPECT_EQ(stats.oracle_evaluations, set_size + stats.reevaluations);
+    EXPECT_EQ(stats.queue_pushes, set_size);
+    EXPECT_EQ(stats.queue_updates, stats.reevaluations);
+    EXPECT_EQ(stats.queue_pops, budget);
+    EXPECT_EQ(stats.iterations.size(), budget);
+
+    // Running again starts the counters over.
+    lazy.run_greedy();
+    EXPECT_EQ(lazy.stats().queue_pops, stats.queue_pops);
+    EXPECT_EQ(lazy.stats().iterations.size(), budget);
+}
+
+// Only implements the set based test, so optimizers go through the stateful fallback.
+class SetOnlyCardinality : public constraint::Constraint<Element>
+{
+public:
+    std::size_t budget;
+
+    SetOnlyCardinality(std::size_t B) : budget(B) {}
+
+    bool test_membership(std::unordered_set<Element *> &set)
+    {
+        return set.size() <= budget;
+    }
+
+    bool is_saturated(std::unordered_set<Element *> &set)
+    {
+        return set.size() == budget;
+    }
+};
+
+TEST_F(ConstrainedModularCost, ConstraintStateTest)
+{
+    // The running knapsack total agrees with testing the whole set.
+    std::unordered_map<Element *, double> knapsack_weights;
+    double weight = 0;
+    for (auto el : *ground_set)
+    {
+        weight = weight + 0.5;
+        knapsack_weights.insert({el, weight});
+    }
+    constraint::Knapsack<Element> knapsack(knapsack_weights, 4.5);
+    auto state = knapsack.new_state();
+    std::unordered_set<Element *> committed;
+    for (auto el : *ground_set)
+    {
+        std::unordered_set<Element *> test_set(committed);
+        test_set.insert(el);
+        EXPECT_EQ(knapsack.can_add(state.get(), el), knapsack.test_membership(test_set));
+        if (knapsack.can_add(state.get(), el))
+        {
+            knapsack.commit(state.get(), el);
+            committed.insert(el);
+            EXPECT_EQ(knapsack.saturated(state.get()), knapsack.is_saturated(committed));
+        }
+    }
+    EXPECT_LE(knapsack.value(committed), 4.5);
+
+    // Constraints without their own state still work through the fallback.
+    SetOnlyCardinality set_only(budget);
+    LazyGreedy<Element> greedy;
+    greedy.set_ground_set(ground_set);
+    greedy.add_constraint(&set_only);
+    greedy.set_cost_function(cost_function);
+    greedy.run_greedy();
+    EXPECT_TRUE(greedy.constraint_saturated);
+    EXPECT_FLOAT_EQ(greedy.curr_val, optimal_value);
+    EXPECT_EQ(greedy.curr_set, optimal_set);
+}
+
+TEST_F(ConstrainedModularCost, PartitionMatroidTest)
+{
+    // The heaviest half of the ground set may contribute one element, the lightest half two.
+    std::unordered_map<Element *, uint32_t> parts;
+    for (auto &[el, weight] : weights)
+    {
+        parts.insert({el, (weight > (set_size / 2) * (set_size / 2)) ? 0u : 1u});
+    }
+    constraint::PartitionMatroid<Element> partition(parts, {1, 2});
+    double expected_value = 100 + 25 + 16;
+
+    auto state = partition.new_state();
+    std::unordered_set<Element *> committed;
+    for (auto el : *ground_set)
+    {
+        std::unordered_set<Element *> test_set(committed);
+        test_set.insert(el);
+        EXPECT_EQ(partition.can_add(state.get(), el), partition.test_membership(test_set));
+        if (partition.can_add(state.get(), el))
+        {
+            partition.commit(state.get(), el);
+            committed.insert(el);
+            EXPECT_EQ(partition.saturated(state.get()), partition.is_saturated(committed));
+        }
+    }
+    EXPECT_TRUE(partition.saturated(state.get()));
+
+    VanillaGreedy<Element> vanilla;
+    vanilla.set_ground_set(ground_set);
+    vanilla.add_constraint(&partition);
+    vanilla.set_cost_function(cost_function);
+    vanilla.run_greedy();
+    EXPECT_FLOAT_EQ(vanilla.curr_val, expected_value);
+
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(ground_set);
+    lazy.add_constraint(&partition);
+    lazy.set_cost_function(cost_function);
+    lazy.run_greedy();
+    EXPECT_TRUE(lazy.constraint_saturated);
+    EXPECT_FLOAT_EQ(lazy.curr_val, expected_value);
+    EXPECT_EQ(lazy.curr_set, vanilla.curr_set);
+
+    // Once the heavy part is full its elements are dropped unchecked, so each later iteration checks only its pick.
+    EXPECT_EQ(lazy.stats().constraint_checks, uint64_t(set_size + 2));
+}
+
+TEST_F(ConstrainedModularCost, StoppingPolicyTest)
+{
+    // Without limits, runs go on until the budget is spent, however large.
+    int large_size = 40;
+    std::unordered_set<Element *> *large_ground_set = generate_ground_set(large_size);
+    costfunction::Modular<Element> uniform_cost(1.0);
+    constraint::Cardinality<Element> large_cardinality(30);
+    LazyGreedy<Element> unlimited;
+    unlimited.set_ground_set(large_ground_set);
+    unlimited.add_constraint(&large_cardinality);
+    unlimited.set_cost_function(&uniform_cost);
+    unlimited.run_greedy();
+    EXPECT_EQ(unlimited.curr_set.size(), 30);
+    EXPECT_EQ(unlimited.stop_reason(), stopping::StopReason::NONE);
+
+    // Weights are 100, 81, 64, ... so each limit below stops the budget 3 run early.
+    auto run = [&](const stopping::StoppingPolicy &policy, stopping::StopReason reason, std::size_t size)
+    {
+        VanillaGreedy<Element> vanilla;
+        vanilla.set_ground_set(ground_set);
+        vanilla.add_constraint(cardinality_constraint);
+        vanilla.set_cost_function(cost_function);
+        vanilla.set_stopping_policy(policy);
+        vanilla.run_greedy();
+        EXPECT_EQ(vanilla.stop_reason(), reason);
+        EXPECT_EQ(vanilla.curr_set.size(), size);
+
+        LazyGreedy<Element> lazy;
+        lazy.set_ground_set(ground_set);
+        lazy.add_constraint(cardinality_constraint);
+        lazy.set_cost_function(cost_function);
+        lazy.set_stopping_policy(policy);
+        lazy.run_greedy();
+        EXPECT_EQ(lazy.stop_reason(), reason);
+        EXPECT_EQ(lazy.curr_set.size(), size);
+        EXPECT_FLOAT_EQ(lazy.curr_val, vanilla.curr_val);
+    };
+
+    stopping::StoppingPolicy max_elements;
+    max_elements.max_elements = 2;
+    run(max_elements, stopping::StopReason::MAX_ELEMENTS, 2);
+
+    stopping::StoppingPolicy max_evaluations;
+    max_evaluations.max_oracle_evaluations = 1; // the first iteration alone would evaluate every element
+    run(max_evaluations, stopping::StopReason::MAX_EVALUATIONS, 0);
+
+    stopping::StoppingPolicy min_gain;
+    min_gain.min_gain = 90; // the element gaining 81 is kept, nothing after it
+    run(min_gain, stopping::StopReason::MIN_GAIN, 2);
+
+    stopping::StoppingPolicy plateau;
+    plateau.plateau_tolerance = 0.5; // 81 <= 0.5 * 181
+    run(plateau, stopping::StopReason::PLATEAU, 2);
+
+    stopping::StoppingPolicy deadline;
+    deadline.max_seconds = 0;
+    run(deadline, stopping::StopReason::DEADLINE, 0);
+
+    // A run that ends by itself again reports no limit.
+    run(stopping::StoppingPolicy(), stopping::StopReason::NONE, budget);
+}
+
+TEST(StoppingPolicy, HardLimitTest)
+{
+    // The evaluation limit is checked within iterations too, so no run spends more than it, however it is split.
+    int large_size = 40;
+    groundset::GroundSet<Element> V(*generate_ground_set(large_size));
+    std::unordered_map<Element *, double> weights;
+    for (uint32_t j = 0; j < V.size(); j++)
+    {
+        weights[V[j]] = j + 1;
+    }
+    costfunction::Modular<Element> modular(weights);
+    constraint::Cardinality<Element> cardinality(30);
+
+    auto check = [&](auto &optimizer, uint64_t limit, const char *name)
+    {
+        stopping::StoppingPolicy policy;
+        policy.max_oracle_evaluations = limit;
+        optimizer.set_ground_set(&V);
+        optimizer.add_constraint(&cardinality);
+        optimizer.set_cost_function(&modular);
+        optimizer.set_stopping_policy(policy);
+        optimizer.run_greedy();
+        EXPECT_EQ(optimizer.stop_reason(), stopping::StopReason::MAX_EVALUATIONS) << name;
+        EXPECT_LE(optimizer.stats().oracle_evaluations, limit) << name;
+        EXPECT_LT(optimizer.curr_set.size(), 30) << name;
+
+        // the abandoned iteration is not recorded, and the set is the one the last complete iteration left
+        EXPECT_EQ(optimizer.stats().iterations.size(), optimizer.curr_set.size()) << name;
+        EXPECT_FLOAT_EQ(optimizer.curr_val, modular.evaluate(optimizer.curr_set)) << name;
+    };
+
+    for (int threads : {1, 2})
+    {
+        // the second scan (39 evaluations) no longer fits after the first (40)
+        VanillaGreedy<Element> vanilla;
+        vanilla.set_num_threads(threads);
+        check(vanilla, 50, "VanillaGreedy");
+        EXPECT_EQ(vanilla.curr_set.size(), 1);
+
+        // ten re-evaluations fit after the first iteration
+        LazyGreedy<Element> lazy;
+        lazy.set_num_threads(threads);
+        check(lazy, 50, "LazyGreedy");
+        EXPECT_EQ(lazy.stats().oracle_evaluations, 50);
+        EXPECT_EQ(lazy.curr_set.size(), 11);
+    }
+
+    StochasticGreedy<Element> stochastic;
+    check(stochastic, 20, "StochasticGreedy");
+
+    LazierThanLazyGreedy<Element> lazier;
+    check(lazier, 20, "LazierThanLazyGreedy");
+}
+
+TEST_F(ConstrainedModularCost, TraceSinkTest)
+{
+    // Nothing is printed without a sink.
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(ground_set);
+    lazy.add_constraint(cardinality_constraint);
+    lazy.set_cost_function(cost_function);
+    testing::internal::CaptureStdout();
+    lazy.run_greedy();
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+
+    // One JSON line per iteration, then one for the run.
+    if (!telemetry::compiled(telemetry::TraceLevel::ITERATION))
+    {
+        GTEST_SKIP() << "Iteration tracing is compiled out, SFO_TRACE_LEVEL " << SFO_TRACE_LEVEL;
+    }
+    std::ostringstream out;
+    telemetry::JsonLinesSink sink(out);
+    lazy.set_trace_sink(&sink);
+    lazy.run_greedy();
+
+    std::vector<std::string> lines;
+    std::istringstream in(out.str());
+    for (std::string line; std::getline(in, line);)
+    {
+        lines.push_back(line);
+    }
+    ASSERT_EQ(lines.size(), lazy.stats().iterations.size() + 1);
+    for (std::size_t i = 0; i + 1 < lines.size(); i++)
+    {
+        EXPECT_EQ(lines[i].rfind("{\"event\":\"iteration\",\"optimizer\":\"LazyGreedy\",\"iteration\":" + std::to_string(i + 1) + ",", 0), 0) << lines[i];
+        EXPECT_EQ(lines[i].back(), '}');
+    }
+    EXPECT_EQ(lines.back().rfind("{\"event\":\"run\",", 0), 0) << lines.back();
+    EXPECT_NE(lines.back().find("\"set_size\":" + std::to_string(budget) + ","), std::string::npos) << lines.back();
+
+    // Debug messages are escaped, and stay off unless compiled in and asked for.
+    std::ostringstream debug_out;
+    telemetry::JsonLinesSink debug_sink(debug_out, telemetry::TraceLevel::DEBUG);
+    telemetry::Tracer tracer;
+    tracer.sink = &debug_sink;
+    tracer.debug([](auto &os)
+                 { os << "a \"quoted\"\nline"; });
+    if (telemetry::compiled(telemetry::TraceLevel::DEBUG))
+    {
+        EXPECT_EQ(debug_out.str(), "{\"event\":\"message\",\"level\":3,\"text\":\"a \\\"quoted\\\"\\nline\"}\n");
+    }
+    else
+    {
+        EXPECT_EQ(debug_out.str(), "");
+    }
+}
+
 TEST_F(ConstrainedModularCost, StochasticGreedyTest)
 {
     // now, let's create an algorithm object to operate on that ground set.
@@ -147,6 +582,135 @@ TEST_F(ConstrainedModularCost, LazierThanLazyGreedyTest)
     EXPECT_EQ(greedy.curr_set, optimal_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
 }
 
+TEST_F(ConstrainedModularCost, StochasticNegativeGainTest)
+{
+    // With every gain negative, the sampling optimizers stop with an empty set instead of sampling forever.
+    std::unordered_map<Element *, double> negative_weights;
+    for (auto el : (*ground_set))
+    {
+        negative_weights.insert({el, -1});
+    }
+    costfunction::Modular<Element> negative(negative_weights);
+
+    StochasticGreedy<Element> stochastic;
+    stochastic.set_ground_set(ground_set);
+    stochastic.add_constraint(cardinality_constraint);
+    stochastic.set_cost_function(&negative);
+    stochastic.run_greedy();
+    EXPECT_TRUE(stochastic.constraint_saturated);
+    EXPECT_TRUE(stochastic.curr_set.empty());
+
+    LazierThanLazyGreedy<Element> lazier;
+    lazier.set_ground_set(ground_set);
+    lazier.add_constraint(cardinality_constraint);
+    EXPECT_FALSE(lazier.is_configured()); // no cost function yet, so a run does nothing
+    lazier.run_greedy();
+    EXPECT_TRUE(lazier.curr_set.empty());
+    lazier.set_cost_function(&negative);
+    lazier.run_greedy();
+    EXPECT_TRUE(lazier.constraint_saturated);
+    EXPECT_TRUE(lazier.curr_set.empty());
+}
+
+TEST_F(ConstrainedModularCost, StochasticLargeBudgetTest)
+{
+    // A budget close to n makes n/b*log(1/epsilon) smaller than one, still at least one element is sampled a step.
+    constraint::Cardinality<Element> large(set_size - 1);
+    StochasticGreedy<Element> greedy;
+    greedy.set_ground_set(ground_set);
+    greedy.add_constraint(&large);
+    greedy.set_cost_function(cost_function);
+    greedy.set_epsilon(0.5);
+    greedy.run_greedy();
+    EXPECT_EQ(greedy.curr_set.size(), set_size - 1);
+    EXPECT_FLOAT_EQ(greedy.curr_val, cost_function->evaluate(greedy.curr_set));
+}
+
+TEST_F(ConstrainedModularCost, ThresholdGreedyTest)
+{
+    // Create an algorithm object.
+    ThresholdGreedy<Element> greedy;
+
+    greedy.set_ground_set(ground_set);
+    greedy.add_constraint(cardinality_constraint);
+    greedy.set_cost_function(cost_function);
+    greedy.set_epsilon(0.1);
+
+    greedy.run_greedy();
+
+    // Constraint should be saturated.
+    EXPECT_TRUE(greedy.constraint_saturated);
+    EXPECT_EQ(greedy.curr_set.size(), budget);
+
+    // Weights i**2 are further apart than the threshold steps, so the thresholds pick the optimal set in order.
+    EXPECT_FLOAT_EQ(greedy.curr_val, optimal_value) << "Optimizer result: " << greedy.curr_val << " Optimal: " << optimal_value;
+    EXPECT_EQ(greedy.curr_set, optimal_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
+}
+
+TEST_F(ConstrainedModularCost, GreeDiTest)
+{
+    // Create an algorithm object.
+    GreeDi<Element> greedy;
+
+    greedy.set_ground_set(ground_set);
+    greedy.add_constraint(cardinality_constraint);
+    greedy.set_cost_function(cost_function);
+    greedy.set_num_shards(2);
+
+    greedy.run_greedy();
+
+    // Constraint should be saturated.
+    EXPECT_TRUE(greedy.constraint_saturated);
+    EXPECT_EQ(greedy.curr_set.size(), budget);
+
+    // Every shard keeps its own heaviest elements, so the merged round sees the optimal set.
+    EXPECT_EQ(greedy.best_shard, -1);
+    EXPECT_FLOAT_EQ(greedy.curr_val, optimal_value) << "Optimizer result: " << greedy.curr_val << " Optimal: " << optimal_value;
+    EXPECT_EQ(greedy.curr_set, optimal_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
+}
+
+TEST_F(ConstrainedModularCost, StaticGreedyTest)
+{
+    using Cost = costfunction::Modular<Element>;
+    using Budget = constraint::Cardinality<Element>;
+    static_assert(dispatch::IncrementalCostFunction<Cost, Element>);
+    static_assert(dispatch::KnapsackConstraint<Budget, Element>);
+    static_assert(dispatch::StatefulConstraint<constraint::PartitionMatroid<Element>, Element>);
+
+    // The cost function and constraint types are template parameters, so no call goes through a vtable.
+    Cost *F = static_cast<Cost *>(cost_function);
+    Budget *C = static_cast<Budget *>(cardinality_constraint);
+
+    static_greedy::VanillaGreedy<Element, Cost, Budget> vanilla(F, C);
+    vanilla.set_ground_set(ground_set);
+    vanilla.run_greedy();
+
+    EXPECT_TRUE(vanilla.constraint_saturated);
+    EXPECT_FLOAT_EQ(vanilla.curr_val, optimal_value) << "Optimizer result: " << vanilla.curr_val << " Optimal: " << optimal_value;
+    EXPECT_EQ(vanilla.curr_set, optimal_set) << "Optimizer set: " << vanilla.curr_set << " Optimal: " << optimal_set;
+
+    static_greedy::LazyGreedy<Element, Cost, Budget> lazy(F, C);
+    lazy.set_ground_set(ground_set);
+    for (bool cost_benefit : {false, true})
+    {
+        // the cardinality is a knapsack, found at compile time for cost-benefit runs
+        lazy.set_cost_benefit(cost_benefit);
+        lazy.run_greedy();
+
+        EXPECT_TRUE(lazy.constraint_saturated);
+        EXPECT_EQ(lazy.curr_set.size(), budget);
+        EXPECT_FLOAT_EQ(lazy.curr_val, optimal_value) << "Optimizer result: " << lazy.curr_val << " Optimal: " << optimal_value;
+        EXPECT_EQ(lazy.curr_set, optimal_set) << "Optimizer set: " << lazy.curr_set << " Optimal: " << optimal_set;
+    }
+
+    // Without a knapsack among the constraints there is nothing to weigh elements by.
+    constraint::PartitionMatroid<Element> *unset = nullptr;
+    static_greedy::LazyGreedy<Element, Cost, constraint::PartitionMatroid<Element>> no_knapsack(F, unset);
+    no_knapsack.set_ground_set(ground_set);
+    no_knapsack.set_cost_benefit(true);
+    EXPECT_FALSE(no_knapsack.is_configured());
+}
+
 // Tests for monotone square root modular cost.
 
 TEST_F(SqrtModularCost, VanillaGreedyTest)
@@ -191,4 +755,518 @@ TEST_F(SqrtModularCost, VanillaGreedyCostBenefitTest)
     // We should have the optimal cost, since the cost function is sufficiently simple.
     EXPECT_FLOAT_EQ(greedy.curr_val, optimal_value) << "Optimizer result: " << greedy.curr_val << " Optimal: " << optimal_value;
     EXPECT_EQ(greedy.curr_set, optimal_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
+}
+
+TEST_F(SqrtModularCost, LazyGreedyParallelTest)
+{
+    // Marginals shrink as the set grows here, so stale entries really are re-evaluated in batches.
+    LazyGreedy<Element> greedy;
+
+    greedy.set_ground_set(ground_set);
+    greedy.add_constraint(cardinality_constraint);
+    greedy.set_cost_function(cost_function);
+    greedy.set_num_threads(4);
+    greedy.set_reevaluation_batch(4);
+
+    greedy.run_greedy();
+
+    // Constraint should be saturated.
+    EXPECT_TRUE(greedy.constraint_saturated);
+    EXPECT_EQ(greedy.curr_set.size(), budget);
+
+    // We should have the optimal cost, since the cost function is sufficiently simple.
+    EXPECT_FLOAT_EQ(greedy.curr_val, optimal_value) << "Optimizer result: " << greedy.curr_val << " Optimal: " << optimal_value;
+    EXPECT_EQ(greedy.curr_set, optimal_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
+}
+
+// Tests for monotone sparse facility location.
+
+TEST(SparseFacilityLocationCost, LazyAndStochasticGreedyTest)
+{
+    // Elements on a ring, each covering itself and its two neighbours on either side.
+    int set_size = 40;
+    int budget = 5;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    costfunction::SparseFacilityLocation<Element> facility_location = ring_facility_location(V);
+    constraint::Cardinality<Element> cardinality(budget);
+
+    VanillaGreedy<Element> vanilla;
+    vanilla.set_ground_set(&V);
+    vanilla.add_constraint(&cardinality);
+    vanilla.set_cost_function(&facility_location);
+    vanilla.run_greedy();
+
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(&V);
+    lazy.add_constraint(&cardinality);
+    lazy.set_cost_function(&facility_location);
+    lazy.run_greedy();
+
+    // Lazy greedy makes the same choices as vanilla greedy on a submodular function.
+    EXPECT_TRUE(lazy.constraint_saturated);
+    EXPECT_EQ(lazy.curr_set, vanilla.curr_set) << "Optimizer set: " << lazy.curr_set << " Vanilla: " << vanilla.curr_set;
+    EXPECT_FLOAT_EQ(lazy.curr_val, facility_location.evaluate(lazy.curr_set));
+
+    StochasticGreedy<Element> stochastic;
+    stochastic.set_ground_set(&V);
+    stochastic.add_constraint(&cardinality);
+    stochastic.set_cost_function(&facility_location);
+    stochastic.set_epsilon(0.1);
+    stochastic.run_greedy();
+
+    EXPECT_TRUE(stochastic.constraint_saturated);
+    EXPECT_EQ(stochastic.curr_set.size(), budget);
+    EXPECT_FLOAT_EQ(stochastic.curr_val, facility_location.evaluate(stochastic.curr_set));
+}
+
+TEST(SparseFacilityLocationCost, StochasticSeedTest)
+{
+    // Elements on a ring, sampled a small fraction at a time.
+    int set_size = 2000;
+    int budget = 20;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    costfunction::SparseFacilityLocation<Element> facility_location = ring_facility_location(V);
+    constraint::Cardinality<Element> cardinality(budget);
+
+    StochasticGreedy<Element> stochastic;
+    stochastic.set_ground_set(&V);
+    stochastic.add_constraint(&cardinality);
+    stochastic.set_cost_function(&facility_location);
+    stochastic.set_epsilon(0.1);
+    stochastic.set_seed(11);
+    stochastic.run_greedy();
+    std::unordered_set<Element *> first_run = stochastic.curr_set;
+
+    // Every iteration draws the same number of distinct ids, and selected ones are never drawn again.
+    uint64_t sample_size = uint64_t((double(set_size) / budget) * std::log(1.0 / 0.1));
+    EXPECT_EQ(stochastic.curr_set.size(), budget);
+    EXPECT_EQ(stochastic.stats().samples_drawn, budget * sample_size);
+    EXPECT_EQ(stochastic.stats().oracle_evaluations, budget * sample_size);
+
+    // Runs are reproducible from the seed, and another seed draws other samples.
+    stochastic.run_greedy();
+    EXPECT_EQ(stochastic.curr_set, first_run);
+    stochastic.set_seed(12);
+    stochastic.run_greedy();
+    EXPECT_NE(stochastic.curr_set, first_run);
+    EXPECT_FLOAT_EQ(stochastic.curr_val, facility_location.evaluate(stochastic.curr_set));
+
+    LazierThanLazyGreedy<Element> lazier;
+    lazier.set_ground_set(&V);
+    lazier.add_constraint(&cardinality);
+    lazier.set_cost_function(&facility_location);
+    lazier.set_epsilon(0.1);
+    lazier.set_seed(11);
+    lazier.run_greedy();
+    first_run = lazier.curr_set;
+
+    EXPECT_EQ(lazier.curr_set.size(), budget);
+    EXPECT_EQ(lazier.stats().samples_drawn, budget * sample_size);
+    EXPECT_LT(lazier.stats().oracle_evaluations, budget * sample_size); // bounds kept across samples skip evaluations
+    lazier.run_greedy();
+    EXPECT_EQ(lazier.curr_set, first_run);
+    EXPECT_FLOAT_EQ(lazier.curr_val, facility_location.evaluate(lazier.curr_set));
+}
+
+TEST(SparseFacilityLocationCost, ThresholdGreedyParallelTest)
+{
+    // A large budget, where threshold greedy needs far fewer marginals than greedy.
+    int set_size = 2000;
+    int budget = 200;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    costfunction::SparseFacilityLocation<Element> facility_location = ring_facility_location(V);
+    constraint::Cardinality<Element> cardinality(budget);
+
+    VanillaGreedy<Element> vanilla;
+    vanilla.set_ground_set(&V);
+    vanilla.add_constraint(&cardinality);
+    vanilla.set_cost_function(&facility_location);
+    vanilla.run_greedy();
+
+    double epsilon = 0.1;
+    ThresholdGreedy<Element> serial;
+    serial.set_ground_set(&V);
+    serial.add_constraint(&cardinality);
+    serial.set_cost_function(&facility_location);
+    serial.set_epsilon(epsilon);
+    serial.run_greedy();
+
+    EXPECT_TRUE(serial.constraint_saturated);
+    EXPECT_FLOAT_EQ(serial.curr_val, facility_location.evaluate(serial.curr_set));
+    EXPECT_GE(serial.curr_val, (1 - 1 / std::exp(1.0) - epsilon) * vanilla.curr_val);
+    EXPECT_LT(serial.stats().oracle_evaluations, vanilla.stats().oracle_evaluations / 10);
+
+    // Elements are accepted in id order whatever the thread count, so the parallel passes agree exactly.
+    ThresholdGreedy<Element> parallel;
+    parallel.set_ground_set(&V);
+    parallel.add_constraint(&cardinality);
+    parallel.set_cost_function(&facility_location);
+    parallel.set_epsilon(epsilon);
+    parallel.set_num_threads(4);
+    parallel.run_greedy();
+
+    EXPECT_EQ(parallel.curr_set, serial.curr_set);
+    EXPECT_FLOAT_EQ(parallel.curr_val, serial.curr_val);
+}
+
+TEST(SparseFacilityLocationCost, GreeDiParallelTest)
+{
+    // Elements on a ring, cut into shards that each hold every fourth element.
+    int set_size = 2000;
+    int budget = 20;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    costfunction::SparseFacilityLocation<Element> facility_location = ring_facility_location(V);
+    constraint::Cardinality<Element> cardinality(budget);
+
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(&V);
+    lazy.add_constraint(&cardinality);
+    lazy.set_cost_function(&facility_location);
+    lazy.run_greedy();
+
+    GreeDi<Element> serial;
+    serial.set_ground_set(&V);
+    serial.add_constraint(&cardinality);
+    serial.set_cost_function(&facility_location);
+    serial.set_num_shards(4);
+    serial.run_greedy();
+
+    EXPECT_EQ(serial.curr_set.size(), budget);
+    EXPECT_FLOAT_EQ(serial.curr_val, facility_location.evaluate(serial.curr_set));
+    EXPECT_GE(serial.curr_val, 0.9 * lazy.curr_val);
+    for (int s = 0; s < 4; s++)
+    {
+        EXPECT_GE(serial.curr_val, serial.shard(s).curr_val);
+        EXPECT_EQ(serial.shard(s).curr_set.size(), budget);
+    }
+
+    // Shards running at once make the same choices.
+    GreeDi<Element> parallel;
+    parallel.set_ground_set(&V);
+    parallel.add_constraint(&cardinality);
+    parallel.set_cost_function(&facility_location);
+    parallel.set_num_shards(4);
+    parallel.set_num_threads(4);
+    parallel.run_greedy();
+
+    EXPECT_EQ(parallel.curr_set, serial.curr_set);
+    EXPECT_FLOAT_EQ(parallel.curr_val, serial.curr_val);
+    EXPECT_EQ(parallel.stats().oracle_evaluations, serial.stats().oracle_evaluations);
+}
+
+TEST(SparseFacilityLocationCost, StaticLazyGreedyTest)
+{
+    // Elements on a ring, optimized by the type-erased and the statically dispatched lazy greedy.
+    int set_size = 2000;
+    int budget = 20;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    using Cost = costfunction::SparseFacilityLocation<Element>;
+    Cost facility_location = ring_facility_location(V);
+    constraint::Cardinality<Element> cardinality(budget);
+    std::unordered_map<Element *, uint32_t> parts;
+    for (uint32_t j = 0; j < V.size(); j++)
+    {
+        parts[V[j]] = j % 4;
+    }
+    constraint::PartitionMatroid<Element> matroid(parts, {3, 3, 3, 3});
+
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(&V);
+    lazy.add_constraint(&cardinality);
+    lazy.add_constraint(&matroid);
+    lazy.set_cost_function(&facility_location);
+    lazy.run_greedy();
+
+    static_greedy::LazyGreedy<Element, Cost, constraint::Cardinality<Element>, constraint::PartitionMatroid<Element>> fast(&facility_location, &cardinality, &matroid);
+    fast.set_ground_set(&V);
+    fast.run_greedy();
+
+    // Both make the same choices, and the matroid fills up before the budget does.
+    EXPECT_TRUE(fast.constraint_saturated);
+    EXPECT_EQ(fast.curr_set.size(), 12);
+    EXPECT_EQ(fast.curr_set, lazy.curr_set) << "Optimizer set: " << fast.curr_set << " Type-erased: " << lazy.curr_set;
+    EXPECT_FLOAT_EQ(fast.curr_val, facility_location.evaluate(fast.curr_set));
+    EXPECT_FLOAT_EQ(fast.curr_val, lazy.curr_val);
+
+    static_greedy::VanillaGreedy<Element, Cost, constraint::Cardinality<Element>> vanilla(&facility_location, &cardinality);
+    vanilla.set_ground_set(&V);
+    vanilla.run_greedy();
+    EXPECT_EQ(vanilla.curr_set.size(), budget);
+    EXPECT_FLOAT_EQ(vanilla.curr_val, facility_location.evaluate(vanilla.curr_set));
+}
+
+template <typename Cost, typename... Constraints>
+void expect_same_choices(groundset::GroundSet<Element> &V, Cost &F, const bool &cost_benefit, Constraints *...C)
+{
+    // runs the type-erased and the static greedy optimizers on the same problem, which must select the same elements in the same order
+    VanillaGreedy<Element> vanilla;
+    vanilla.set_ground_set(&V);
+    (vanilla.add_constraint(C), ...);
+    vanilla.set_cost_function(&F);
+    vanilla.set_cost_benefit(cost_benefit);
+    vanilla.run_greedy();
+    ASSERT_GT(vanilla.path().size(), 0);
+
+    for (int threads : {1, 2})
+    {
+        LazyGreedy<Element> lazy;
+        lazy.set_ground_set(&V);
+        (lazy.add_constraint(C), ...);
+        lazy.set_cost_function(&F);
+        lazy.set_cost_benefit(cost_benefit);
+        lazy.set_num_threads(threads);
+        lazy.set_reevaluation_batch(2 * threads - 1);
+        lazy.run_greedy();
+        EXPECT_EQ(lazy.path().ids, vanilla.path().ids) << "LazyGreedy with " << threads << " threads";
+    }
+
+    static_greedy::VanillaGreedy<Element, Cost, Constraints...> static_vanilla(&F, C...);
+    static_vanilla.set_ground_set(&V);
+    static_vanilla.set_cost_benefit(cost_benefit);
+    static_vanilla.run_greedy();
+    EXPECT_EQ(static_vanilla.path().ids, vanilla.path().ids) << "static VanillaGreedy";
+
+    static_greedy::LazyGreedy<Element, Cost, Constraints...> static_lazy(&F, C...);
+    static_lazy.set_ground_set(&V);
+    static_lazy.set_cost_benefit(cost_benefit);
+    static_lazy.run_greedy();
+    EXPECT_EQ(static_lazy.path().ids, vanilla.path().ids) << "static LazyGreedy";
+    EXPECT_FLOAT_EQ(static_lazy.curr_val, vanilla.curr_val);
+}
+
+TEST(StaticGreedy, ConsistentChoicesTest)
+{
+    /* The type-erased optimizers run the static ones through virtual calls and an Intersection of their
+     *  constraints, so check that both dispatches, threads and batching select alike across cost functions and
+     *  constraints.
+     */
+    int set_size = 300;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    std::unordered_map<Element *, double> weights;
+    std::unordered_map<Element *, double> knapsack_weights;
+    std::unordered_map<Element *, uint32_t> parts;
+    for (uint32_t j = 0; j < V.size(); j++)
+    {
+        weights[V[j]] = 1 + (j * 7919) % 1009;
+        knapsack_weights[V[j]] = 1 + (j * 104729) % 13 + j / 1000.0;
+        parts[V[j]] = j % 5;
+    }
+    costfunction::Modular<Element> modular(weights);
+    costfunction::SqrtModular<Element> sqrt_modular(modular);
+    costfunction::SparseFacilityLocation<Element> facility_location = ring_facility_location(V, 3, 11);
+    constraint::Cardinality<Element> cardinality(25);
+    constraint::Knapsack<Element> knapsack(knapsack_weights, 60);
+    constraint::PartitionMatroid<Element> matroid(parts, {4, 2, 4, 2, 4});
+
+    std::vector<double> kernel(V.size() * V.size());
+    for (uint32_t i = 0; i < V.size(); i++)
+    {
+        for (uint32_t j = 0; j < V.size(); j++)
+        {
+            double distance = 0.05 * (double(i) - double(j)) + double(i % 3) - double(j % 3);
+            kernel[i * V.size() + j] = std::exp(-distance * distance);
+        }
+    }
+    costfunction::LogDet<Element> log_det(V, kernel);
+
+    expect_same_choices(V, sqrt_modular, false, &cardinality);
+    expect_same_choices(V, sqrt_modular, true, &knapsack);
+    expect_same_choices(V, facility_location, false, &cardinality, &matroid);
+    expect_same_choices(V, facility_location, true, &knapsack, &matroid);
+    expect_same_choices(V, log_det, false, &cardinality);
+}
+
+TEST(LazyHeap, MatchesPriorityQueueTest)
+{
+    // Same entries, shrunk and popped in the same order, come out of both queues in the same order.
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> level(0, 20); // coarse values, so there are plenty of ties
+    heap::LazyHeap marginals;
+    LazyGreedyIdQueue reference;
+    for (uint32_t id = 0; id < 1000; id++)
+    {
+        double value = level(rng);
+        marginals.append(id, value, 0);
+        reference.push({id, value});
+    }
+    marginals.heapify();
+
+    for (uint32_t step = 1; !reference.empty(); step++)
+    {
+        ASSERT_EQ(marginals.size(), reference.size());
+        ASSERT_EQ(marginals.top_id(), reference.top().first);
+        ASSERT_EQ(marginals.top_value(), reference.top().second);
+        if (step % 3 == 0)
+        {
+            marginals.pop();
+            reference.pop();
+        }
+        else
+        {
+            double value = marginals.top_value() - level(rng) % 3;
+            uint32_t id = reference.top().first;
+            marginals.update_top(value, step);
+            reference.pop();
+            reference.push({id, value});
+            if (marginals.top_id() == id)
+            {
+                EXPECT_EQ(marginals.top_stamp(), step); // fresh this step, so lazy greedy takes it as is
+            }
+        }
+        if (step % 100 == 0)
+        {
+            double value = level(rng);
+            marginals.push(10000 + step, value, step);
+            reference.push({10000 + step, value});
+        }
+    }
+    EXPECT_TRUE(marginals.empty());
+}
+
+TEST(SparseFacilityLocationCost, CachedCostParallelTest)
+{
+    // Elements on a ring, behind a cache that the optimizers do not know about.
+    int set_size = 2000;
+    int budget = 20;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    costfunction::SparseFacilityLocation<Element> facility_location = ring_facility_location(V);
+    costfunction::CachedCostFunction<Element> cached(&facility_location);
+    constraint::Cardinality<Element> cardinality(budget);
+
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(&V);
+    lazy.add_constraint(&cardinality);
+    lazy.set_cost_function(&facility_location);
+    lazy.run_greedy();
+
+    LazyGreedy<Element> cached_lazy;
+    cached_lazy.set_ground_set(&V);
+    cached_lazy.add_constraint(&cardinality);
+    cached_lazy.set_cost_function(&cached);
+    cached_lazy.set_num_threads(4);
+    cached_lazy.set_reevaluation_batch(8);
+    cached_lazy.run_greedy();
+
+    EXPECT_EQ(cached_lazy.curr_set, lazy.curr_set);
+    EXPECT_FLOAT_EQ(cached_lazy.curr_val, lazy.curr_val);
+
+    // A second run asks for the same (set, element) pairs, so the wrapped oracle is not called again.
+    uint64_t misses = cached.misses();
+    cached_lazy.run_greedy();
+    EXPECT_EQ(cached_lazy.curr_set, lazy.curr_set);
+    EXPECT_EQ(cached.misses(), misses);
+    EXPECT_GE(cached.hits(), cached_lazy.stats().oracle_evaluations);
+
+    // Stochastic greedy runs with the same seed hit as well.
+    StochasticGreedy<Element> stochastic;
+    stochastic.set_ground_set(&V);
+    stochastic.add_constraint(&cardinality);
+    stochastic.set_cost_function(&cached);
+    stochastic.set_epsilon(0.1);
+    stochastic.run_greedy();
+    misses = cached.misses();
+    stochastic.run_greedy();
+    EXPECT_EQ(cached.misses(), misses);
+    EXPECT_FLOAT_EQ(stochastic.curr_val, facility_location.evaluate(stochastic.curr_set));
+}
+
+// Tests for monotone log determinant.
+
+TEST(SparseFacilityLocationCost, SolutionPathTest)
+{
+    // One run to the largest budget holds the greedy solution of every smaller one.
+    int set_size = 500;
+    int k_max = 20;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    costfunction::SparseFacilityLocation<Element> facility_location = ring_facility_location(V, 3, 11);
+    constraint::Cardinality<Element> cardinality(k_max);
+
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(&V);
+    lazy.add_constraint(&cardinality);
+    lazy.set_cost_function(&facility_location);
+    lazy.run_greedy();
+    const solution::SolutionPath<Element> &path = lazy.path();
+    ASSERT_EQ(path.size(), k_max);
+    EXPECT_EQ(path.prefix(k_max), lazy.curr_set);
+    EXPECT_FLOAT_EQ(path.value(k_max), lazy.curr_val);
+    EXPECT_EQ(path.value(0), 0);
+    EXPECT_FLOAT_EQ(std::accumulate(path.gains.begin(), path.gains.end(), 0.0), path.values.back());
+
+    for (int k : {1, 5, 13})
+    {
+        constraint::Cardinality<Element> smaller(k);
+        VanillaGreedy<Element> vanilla;
+        vanilla.set_ground_set(&V);
+        vanilla.add_constraint(&smaller);
+        vanilla.set_cost_function(&facility_location);
+        vanilla.run_greedy();
+        EXPECT_EQ(path.prefix(k), vanilla.curr_set);
+        EXPECT_FLOAT_EQ(path.value(k), vanilla.curr_val);
+        EXPECT_FLOAT_EQ(path.value(k), facility_location.evaluate(vanilla.curr_set));
+    }
+
+    // The path survives a round trip through its binary form.
+    std::stringstream buffer;
+    path.write(buffer);
+    EXPECT_EQ(buffer.str().size(), sizeof(uint64_t) + sizeof(double) + k_max * (sizeof(uint32_t) + sizeof(double)));
+    solution::SolutionPath<Element> read_back;
+    EXPECT_TRUE(read_back.read(buffer, &V));
+    EXPECT_EQ(read_back.ids, path.ids);
+    EXPECT_EQ(read_back.values, path.values);
+    EXPECT_EQ(read_back.prefix(7), path.prefix(7));
+    std::stringstream truncated(buffer.str().substr(0, 40));
+    EXPECT_FALSE(read_back.read(truncated, &V));
+    EXPECT_EQ(read_back.ids, path.ids); // a failed read leaves the path alone
+
+    // Ids beyond the ground set are rejected rather than read into the path.
+    int smaller_size = 10;
+    groundset::GroundSet<Element> smaller(*generate_ground_set(smaller_size));
+    std::stringstream mismatched(buffer.str());
+    EXPECT_FALSE(read_back.read(mismatched, &smaller));
+    EXPECT_EQ(read_back.ids, path.ids);
+}
+
+TEST(LogDetCost, LazyGreedyTest)
+{
+    // Clustered points: greedy should spread its picks over the clusters, and lazy greedy should agree with vanilla.
+    int set_size = 30;
+    int budget = 4;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    std::vector<double> kernel(V.size() * V.size());
+    for (uint32_t i = 0; i < V.size(); i++)
+    {
+        for (uint32_t j = 0; j < V.size(); j++)
+        {
+            double distance = double(i % 4) - double(j % 4) + 0.01 * (double(i) - double(j));
+            kernel[i * V.size() + j] = std::exp(-2 * distance * distance);
+        }
+    }
+    costfunction::LogDet<Element> log_det(V, kernel);
+    constraint::Cardinality<Element> cardinality(budget);
+
+    VanillaGreedy<Element> vanilla;
+    vanilla.set_ground_set(&V);
+    vanilla.add_constraint(&cardinality);
+    vanilla.set_cost_function(&log_det);
+    vanilla.run_greedy();
+
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(&V);
+    lazy.add_constraint(&cardinality);
+    lazy.set_cost_function(&log_det);
+    lazy.set_num_threads(2);
+    lazy.set_reevaluation_batch(4);
+    lazy.run_greedy();
+
+    EXPECT_TRUE(lazy.constraint_saturated);
+    EXPECT_EQ(lazy.curr_set, vanilla.curr_set) << "Optimizer set: " << lazy.curr_set << " Vanilla: " << vanilla.curr_set;
+    EXPECT_FLOAT_EQ(lazy.curr_val, log_det.evaluate(lazy.curr_set));
+
+    std::unordered_set<uint32_t> clusters;
+    for (auto el : lazy.curr_set)
+    {
+        clusters.insert(V.id(el) % 4);
+    }
+    EXPECT_EQ(clusters.size(), budget);
 }
\ No newline at end of file
@@ -81,4 +81,20 @@ TEST_F(SqrtModularCost, RandomizedBidirectionalGreedyTest)
     // Since the problem is unconstrained and monotone modular, the optimal should just be all elements.
     EXPECT_FLOAT_EQ(greedy.curr_val, cost_function->evaluate(*ground_set)) << "Optimizer result: " << greedy.curr_val << " Optimal: " << optimal_value;
     EXPECT_EQ(greedy.curr_set, *ground_set) << "Optimizer set: " << greedy.curr_set << " Optimal: " << optimal_set;
-}
\ No newline at end of file
+}
+
+TEST_F(ConstrainedModularCost, BidirectionalGreedyMaxElementsTest)
+{
+    // The top set starts out as the whole ground set, so a size limit has to hold for it too.
+    BidirectionalGreedy<Element> greedy;
+    greedy.set_ground_set(ground_set);
+    greedy.set_cost_function(cost_function);
+    stopping::StoppingPolicy policy;
+    policy.max_elements = 4;
+    greedy.set_stopping_policy(policy);
+    greedy.run_greedy();
+
+    EXPECT_EQ(greedy.stop_reason(), stopping::StopReason::MAX_ELEMENTS);
+    EXPECT_EQ(greedy.curr_set.size(), 4);
+    EXPECT_FLOAT_EQ(greedy.curr_val, cost_function->evaluate(greedy.curr_set));
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// include the algorithms we want
+#include "sfo_cpp/optimizers/streaming/sieve_streaming.hpp"
+#include "sfo_cpp/optimizers/monotone/preemption_streaming.hpp"
+#include "sfo_cpp/optimizers/monotone/lazy_greedy.hpp"
+
+// include the cost function and constraint interfaces
+#include "sfo_cpp/sfo_concepts/ground_set.hpp"
+#include "sfo_cpp/sfo_concepts/cost_function.hpp"
+#include "sfo_cpp/sfo_concepts/facility_location.hpp"
+#include "sfo_cpp/sfo_concepts/constraint.hpp"
+
+// Elements are templated out, include a basic "element" class for testing
+#include "sfo_cpp/tests/test_utils/demo_element.hpp"
+
+// Convenience fixtures for testing various cost functions
+#include "sfo_cpp/tests/test_utils/test_fixtures.hpp"
+
+TEST_F(ConstrainedModularCost, SieveStreamingTest)
+{
+    // Create an algorithm object.
+    SieveStreaming<Element> sieve;
+
+    sieve.set_ground_set(ground_set);
+    sieve.add_constraint(cardinality_constraint);
+    sieve.set_cost_function(cost_function);
+    sieve.set_epsilon(0.1);
+
+    sieve.run_greedy();
+
+    // The best sieve is a (1/2 - epsilon) approximation, and curr_set holds it after the run.
+    EXPECT_LE(sieve.curr_set.size(), budget);
+    EXPECT_EQ(sieve.num_seen, set_size);
+    EXPECT_FLOAT_EQ(sieve.curr_val, cost_function->evaluate(sieve.curr_set));
+    EXPECT_GE(sieve.curr_val, (0.5 - 0.1) * optimal_value) << "Optimizer result: " << sieve.curr_val << " Optimal: " << optimal_value;
+}
+
+TEST_F(ConstrainedModularCost, PreemptionStreamingTest)
+{
+    // Weights i**2 arrive in ground set order, and a member is preempted by anything at least twice its weight.
+    PreemptionStreaming<Element> stream;
+
+    stream.set_ground_set(ground_set);
+    stream.add_constraint(cardinality_constraint);
+    stream.set_cost_function(cost_function);
+    stream.set_replacement_factor(2);
+
+    stream.run_greedy();
+
+    EXPECT_EQ(stream.curr_set.size(), budget);
+    EXPECT_EQ(stream.num_seen, set_size);
+    EXPECT_FLOAT_EQ(stream.curr_val, cost_function->evaluate(stream.curr_set));
+    EXPECT_GE(stream.curr_val, optimal_value / 4) << "Optimizer result: " << stream.curr_val << " Optimal: " << optimal_value;
+
+    // Every arrival is timed, and costs one marginal, and the buffer is evaluated once at the end.
+    EXPECT_EQ(stream.latency().count, set_size);
+    EXPECT_GE(stream.latency().max_seconds, stream.latency().mean_seconds());
+    EXPECT_EQ(stream.stats().oracle_evaluations, set_size + 1);
+    EXPECT_GT(stream.num_swaps, 0);
+
+    // With factor 1 anything beating the weakest member gets in, which for a modular function is the optimum.
+    stream.set_replacement_factor(1);
+    stream.run_greedy();
+    EXPECT_FLOAT_EQ(stream.curr_val, optimal_value);
+    EXPECT_EQ(stream.curr_set, optimal_set);
+}
+
+TEST(SparseFacilityLocationCost, StreamingPushTest)
+{
+    // Elements on a ring, each covering itself and its two neighbours on either side, arriving in random order.
+    int set_size = 2000;
+    int budget = 20;
+    double epsilon = 0.1;
+    groundset::GroundSet<Element> V(*generate_ground_set(set_size));
+    costfunction::SparseFacilityLocation<Element> facility_location = ring_facility_location(V);
+    constraint::Cardinality<Element> cardinality(budget);
+
+    LazyGreedy<Element> lazy;
+    lazy.set_ground_set(&V);
+    lazy.add_constraint(&cardinality);
+    lazy.set_cost_function(&facility_location);
+    lazy.run_greedy();
+
+    std::vector<Element *> stream(V.elements);
+    std::shuffle(stream.begin(), stream.end(), std::mt19937(7));
+
+    SieveStreaming<Element> sieve;
+    sieve.add_constraint(&cardinality);
+    sieve.set_cost_function(&facility_location);
+    sieve.set_epsilon(epsilon);
+    sieve.clear_set();
+
+    // Half element by element, half as a range, never holding more than the live sieves.
+    std::size_t max_sieves = std::size_t(std::log(2.0 * budget) / std::log1p(epsilon)) + 2;
+    for (std::size_t i = 0; i < stream.size() / 2; i++)
+    {
+        sieve.push(stream[i]);
+        EXPECT_LE(sieve.num_sieves(), max_sieves);
+    }
+    sieve.consume(stream.begin() + stream.size() / 2, stream.end());
+    EXPECT_LE(sieve.num_sieves(), max_sieves);
+    EXPECT_EQ(sieve.num_seen, set_size);
+
+    std::unordered_set<Element *> &solution = sieve.solution();
+    EXPECT_LE(solution.size(), budget);
+    EXPECT_FLOAT_EQ(sieve.curr_val, facility_location.evaluate(solution));
+    EXPECT_GE(sieve.curr_val, (0.5 - epsilon) * lazy.curr_val);
+
+    // Each element costs one singleton and at most one marginal per live sieve.
+    EXPECT_LE(sieve.stats().oracle_evaluations, uint64_t(set_size) * (max_sieves + 1));
+
+    PreemptionStreaming<Element> preemption;
+    preemption.add_constraint(&cardinality);
+    preemption.set_cost_function(&facility_location);
+    for (auto el : stream)
+    {
+        preemption.push(el);
+    }
+    preemption.solution();
+
+    // The buffer holds at most the budget, its value is the 1/4 approximation's, and it only swaps occasionally.
+    EXPECT_EQ(preemption.curr_set.size(), budget);
+    EXPECT_FLOAT_EQ(preemption.curr_val, facility_location.evaluate(preemption.curr_set));
+    EXPECT_GE(preemption.curr_val, lazy.curr_val / 4);
+    EXPECT_EQ(preemption.stats().oracle_evaluations, set_size + 1);
+    EXPECT_LT(preemption.num_swaps, set_size / 10);
+}
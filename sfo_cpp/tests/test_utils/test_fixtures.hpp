@@ -3,7 +3,9 @@
 #include <gtest/gtest.h>
 
 // include the cost function and constraint interfaces
+#include "sfo_cpp/sfo_concepts/ground_set.hpp"
 #include "sfo_cpp/sfo_concepts/cost_function.hpp"
+#include "sfo_cpp/sfo_concepts/facility_location.hpp"
 #include "sfo_cpp/sfo_concepts/constraint.hpp"
 
 // Elements are templated out, include a basic "element" class for testing
@@ -112,4 +114,23 @@ protected:
     // Optimal cost and value for this case.
     std::unordered_set<Element *> optimal_set{};
     double optimal_value = 0;
-};
\ No newline at end of file
+};
+
+inline costfunction::SparseFacilityLocation<Element> ring_facility_location(const groundset::GroundSet<Element> &V, const int &radius = 2, const int &period = 7)
+{
+    // Elements on a ring, each covering its neighbors up to radius away, less so the farther they are.
+    // Element j weighs 1 + (j % period) / period, so gains differ and ties are rare.
+    std::vector<std::size_t> offsets = {0};
+    std::vector<uint32_t> neighbors;
+    std::vector<double> similarities;
+    for (uint32_t j = 0; j < V.size(); j++)
+    {
+        for (int d = -radius; d <= radius; d++)
+        {
+            neighbors.push_back((j + V.size() + d) % V.size());
+            similarities.push_back((1 + double(j % period) / period) / (1 + std::abs(d)));
+        }
+        offsets.push_back(neighbors.size());
+    }
+    return costfunction::SparseFacilityLocation<Element>(V, offsets, neighbors, similarities, V.size());
+}
@@ -0,0 +1,201 @@
+// Priority queue of marginal upper bounds for the lazy greedy optimizers.
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace heap
+{
+    class LazyHeap
+    {
+        /* Max-heap of (id, value, stamp) entries, where value is an upper bound on the marginal (or ratio) of
+         *  ground set id and stamp the iteration it was computed in, so a top entry computed in the current
+         *  iteration can be taken as exact. Larger values come first, then lower ids, as with
+         *  compare_id_value_pair. Every node has four children, so the heap is half as deep as a binary one and
+         *  the children of a node share a cache line, and ids, values and stamps are kept in separate arrays
+         *  so sifts only touch the arrays they compare. update_top replaces the top entry's value in place,
+         *  instead of a pop and a push.
+         */
+    public:
+        static constexpr std::size_t ARITY = 4;
+
+        void clear()
+        {
+            ids.clear();
+            values.clear();
+            stamps.clear();
+        }
+
+        void reserve(const std::size_t &capacity)
+        {
+            ids.reserve(capacity);
+            values.reserve(capacity);
+            stamps.reserve(capacity);
+        }
+
+        bool empty() const
+        {
+            return ids.empty();
+        }
+
+        std::size_t size() const
+        {
+            return ids.size();
+        }
+
+        uint32_t top_id() const
+        {
+            return ids[0];
+        }
+
+        double top_value() const
+        {
+            return values[0];
+        }
+
+        uint32_t top_stamp() const
+        {
+            return stamps[0];
+        }
+
+        void append(const uint32_t &id, const double &value, const uint32_t &stamp)
+        {
+            // adds an entry without restoring the heap order, call heapify once done appending
+            ids.push_back(id);
+            values.push_back(value);
+            stamps.push_back(stamp);
+        }
+
+        void heapify()
+        {
+            // restores the heap order over all entries, in O(size)
+            if (size() < 2)
+            {
+                return;
+            }
+            for (std::size_t i = (size() - 2) / ARITY + 1; i-- > 0;)
+            {
+                this->sift_down(i);
+            }
+        }
+
+        void push(const uint32_t &id, const double &value, const uint32_t &stamp)
+        {
+            this->append(id, value, stamp);
+            this->sift_up(size() - 1);
+        }
+
+        void pop()
+        {
+            ids[0] = ids.back();
+            values[0] = values.back();
+            stamps[0] = stamps.back();
+            ids.pop_back();
+            values.pop_back();
+            stamps.pop_back();
+            if (!empty())
+            {
+                this->sift_down(0);
+            }
+        }
+
+        void update_top(const double &value, const uint32_t &stamp)
+        {
+            // the top entry's new bound, usually smaller, sifted down from the root
+            values[0] = value;
+            stamps[0] = stamp;
+            this->sift_down(0);
+        }
+
+        template <typename Keep>
+        void retain(Keep keep)
+        {
+            // drops every entry whose id fails keep(id), then heapifies what is left
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < size(); i++)
+            {
+                if (keep(ids[i]))
+                {
+                    ids[kept] = ids[i];
+                    values[kept] = values[i];
+                    stamps[kept] = stamps[i];
+                    kept++;
+                }
+            }
+            ids.resize(kept);
+            values.resize(kept);
+            stamps.resize(kept);
+            this->heapify();
+        }
+
+    private:
+        std::vector<uint32_t> ids;
+        std::vector<double> values;
+        std::vector<uint32_t> stamps;
+
+        static bool precedes(const double &value, const uint32_t &id, const double &other_value, const uint32_t &other_id)
+        {
+            return value > other_value || (value == other_value && id < other_id);
+        }
+
+        void sift_down(std::size_t i)
+        {
+            // moves entry i down into the hole left by the best child until no child precedes it
+            uint32_t id = ids[i];
+            double value = values[i];
+            uint32_t stamp = stamps[i];
+            std::size_t n = size();
+            while (true)
+            {
+                std::size_t first = ARITY * i + 1;
+                if (first >= n)
+                {
+                    break;
+                }
+                std::size_t last = std::min(first + ARITY, n);
+                std::size_t best = first;
+                for (std::size_t c = first + 1; c < last; c++)
+                {
+                    if (precedes(values[c], ids[c], values[best], ids[best]))
+                    {
+                        best = c;
+                    }
+                }
+                if (!precedes(values[best], ids[best], value, id))
+                {
+                    break;
+                }
+                ids[i] = ids[best];
+                values[i] = values[best];
+                stamps[i] = stamps[best];
+                i = best;
+            }
+            ids[i] = id;
+            values[i] = value;
+            stamps[i] = stamp;
+        }
+
+        void sift_up(std::size_t i)
+        {
+            uint32_t id = ids[i];
+            double value = values[i];
+            uint32_t stamp = stamps[i];
+            while (i > 0)
+            {
+                std::size_t parent = (i - 1) / ARITY;
+                if (!precedes(value, id, values[parent], ids[parent]))
+                {
+                    break;
+                }
+                ids[i] = ids[parent];
+                values[i] = values[parent];
+                stamps[i] = stamps[parent];
+                i = parent;
+            }
+            ids[i] = id;
+            values[i] = value;
+            stamps[i] = stamp;
+        }
+    };
+}
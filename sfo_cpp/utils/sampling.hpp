@@ -0,0 +1,95 @@
+// Seeded sampling of dense ground set ids for the stochastic optimizers.
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace sampling
+{
+    using Rng = std::mt19937_64; // every optimizer owns one, so runs do not share (or race on) global state
+
+    constexpr uint64_t DEFAULT_SEED = 5489; // seed of an optimizer that was never given one
+
+    inline uint32_t uniform_below(Rng &rng, const uint32_t &range)
+    {
+        // uniform in [0, range) by multiply and shift (Lemire, 2019), identical on every standard library
+        uint64_t product = (rng() >> 32) * uint64_t(range);
+        uint32_t low = uint32_t(product);
+        if (low < range)
+        {
+            uint32_t threshold = uint32_t(-range) % range;
+            while (low < threshold)
+            {
+                product = (rng() >> 32) * uint64_t(range);
+                low = uint32_t(product);
+            }
+        }
+        return uint32_t(product >> 32);
+    }
+
+    class IdSampler
+    {
+        /* A pool of the ids 0, ..., n-1 that can still be drawn. draw takes a uniform sample without replacement
+         *  with a partial Fisher-Yates shuffle of the front of the pool, in O(count), and discard swaps an id
+         *  with the last live one and shrinks the pool, in O(1). position tracks where every id sits, so
+         *  ids can be discarded in any order.
+         */
+    public:
+        void reset(const uint32_t &n)
+        {
+            // every id live again
+            pool.resize(n);
+            position.resize(n);
+            std::iota(pool.begin(), pool.end(), 0);
+            std::iota(position.begin(), position.end(), 0);
+            live = n;
+        }
+
+        uint32_t size() const
+        {
+            return live;
+        }
+
+        bool contains(const uint32_t &id) const
+        {
+            return position[id] < live;
+        }
+
+        void discard(const uint32_t &id)
+        {
+            // id is never drawn again (until the next reset)
+            if (!contains(id))
+            {
+                return;
+            }
+            live--;
+            this->swap(position[id], live);
+        }
+
+        void draw(uint32_t count, Rng &rng, std::vector<uint32_t> &out)
+        {
+            // overwrites out with min(count, size()) distinct live ids
+            count = std::min(count, live);
+            out.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                this->swap(i, i + uniform_below(rng, live - i));
+                out[i] = pool[i];
+            }
+        }
+
+    private:
+        std::vector<uint32_t> pool;     // live ids first, discarded ones after them
+        std::vector<uint32_t> position; // where each id is in pool
+        uint32_t live = 0;              // how many ids at the front of pool are live
+
+        void swap(uint32_t i, uint32_t j)
+        {
+            std::swap(pool[i], pool[j]);
+            position[pool[i]] = i;
+            position[pool[j]] = j;
+        }
+    };
+}
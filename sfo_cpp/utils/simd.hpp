@@ -0,0 +1,200 @@
+// Minimal portable SIMD helpers built on compiler vector types.
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace simd
+{
+#if defined(__GNUC__) || defined(__clang__)
+#define SFO_VECTOR_TYPES 1
+    // GCC/Clang vector types lower to whatever the target has (SSE/AVX on x86, NEON on ARM),
+    // sized to one native register so they are passed around in registers
+#if defined(__AVX__)
+    constexpr std::size_t lanes = 4;
+#else
+    constexpr std::size_t lanes = 2;
+#endif
+    typedef double vdouble __attribute__((vector_size(lanes * sizeof(double))));
+    typedef int64_t vint64 __attribute__((vector_size(lanes * sizeof(int64_t))));
+#else
+#define SFO_VECTOR_TYPES 0
+    // no vector types available (e.g. MSVC), everything runs one lane at a time
+    constexpr std::size_t lanes = 1;
+    typedef double vdouble;
+#endif
+
+    inline double sqrt(double x)
+    {
+        return std::sqrt(x);
+    }
+
+    inline double abs(double x)
+    {
+        return std::abs(x);
+    }
+
+#if SFO_VECTOR_TYPES
+    inline vdouble sqrt(vdouble x)
+    {
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_elementwise_sqrt)
+        return __builtin_elementwise_sqrt(x);
+#define SFO_HAS_ELEMENTWISE_SQRT 1
+#endif
+#endif
+#ifndef SFO_HAS_ELEMENTWISE_SQRT
+        // GCC packs this into one vector sqrt when built with -fno-math-errno
+        vdouble r;
+        for (std::size_t l = 0; l < lanes; l++)
+        {
+            r[l] = __builtin_sqrt(x[l]);
+        }
+        return r;
+#endif
+    }
+
+    inline vdouble abs(vdouble x)
+    {
+        // clear the sign bits
+        return (vdouble)((vint64)x & INT64_MAX);
+    }
+#endif
+
+    inline double max(double a, double b)
+    {
+        return (a > b) ? a : b;
+    }
+
+#if SFO_VECTOR_TYPES
+    inline vdouble load(const double *p)
+    {
+        // unaligned load of lanes doubles
+        vdouble x;
+        std::memcpy(&x, p, sizeof(x));
+        return x;
+    }
+
+    inline void store(double *p, vdouble x)
+    {
+        std::memcpy(p, &x, sizeof(x));
+    }
+
+    inline vdouble max(vdouble a, vdouble b)
+    {
+        // pick lanes by mask rather than through a ternary, which not every compiler accepts on vectors
+        vint64 mask = (vint64)(a > b);
+        return (vdouble)(((vint64)a & mask) | ((vint64)b & ~mask));
+    }
+#endif
+
+    inline double sum_positive_difference(const double *a, const double *b, std::size_t count)
+    {
+        // sum over i of max(a[i] - b[i], 0)
+        double sum = 0;
+        std::size_t i = 0;
+#if SFO_VECTOR_TYPES
+        vdouble zero = {};
+        vdouble acc = {};
+        for (; i + lanes <= count; i += lanes)
+        {
+            acc += max(load(a + i) - load(b + i), zero);
+        }
+        for (std::size_t l = 0; l < lanes; l++)
+        {
+            sum = sum + acc[l];
+        }
+#endif
+        for (; i < count; i++)
+        {
+            sum = sum + max(a[i] - b[i], 0.0);
+        }
+        return sum;
+    }
+
+    inline void max_update(double *best, const double *a, std::size_t count)
+    {
+        // best[i] = max(best[i], a[i])
+        std::size_t i = 0;
+#if SFO_VECTOR_TYPES
+        for (; i + lanes <= count; i += lanes)
+        {
+            store(best + i, max(load(a + i), load(best + i)));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            best[i] = max(a[i], best[i]);
+        }
+    }
+
+    inline int popcount(uint64_t x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+#else
+        int count = 0;
+        for (; x; x &= x - 1)
+        {
+            count++;
+        }
+        return count;
+#endif
+    }
+
+    inline int lowest_bit(uint64_t x)
+    {
+        // index of the lowest set bit, x must be nonzero
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(x);
+#else
+        int index = 0;
+        for (; !(x & 1); x >>= 1)
+        {
+            index++;
+        }
+        return index;
+#endif
+    }
+
+    inline uint64_t count_and_not(const uint64_t *a, const uint64_t *b, std::size_t words)
+    {
+        // number of bits set in a but not in b, word-wise so the compiler can unroll and vectorize it
+        uint64_t count = 0;
+        for (std::size_t w = 0; w < words; w++)
+        {
+            count = count + popcount(a[w] & ~b[w]);
+        }
+        return count;
+    }
+
+    template <typename Fn>
+    void gather_transform(const double *dense, const uint32_t *ids, std::size_t count, double *out, Fn fn)
+    {
+        /* Writes out[i] = fn(dense[ids[i]]) for i in [0, count).
+         *  fn is called on whole vectors of gathered values where possible and on single doubles for the tail,
+         *  so it should be a generic lambda built from arithmetic and the simd:: functions above.
+         */
+        std::size_t i = 0;
+#if SFO_VECTOR_TYPES
+        for (; i + lanes <= count; i += lanes)
+        {
+            vdouble x;
+            for (std::size_t l = 0; l < lanes; l++)
+            {
+                x[l] = dense[ids[i + l]];
+            }
+            vdouble y = fn(x);
+            for (std::size_t l = 0; l < lanes; l++)
+            {
+                out[i + l] = y[l];
+            }
+        }
+#endif
+        for (; i < count; i++)
+        {
+            out[i] = fn(dense[ids[i]]);
+        }
+    }
+}
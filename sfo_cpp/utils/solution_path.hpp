@@ -0,0 +1,118 @@
+// The order in which a greedy run selected its elements, so every budget up to the run's can be read off it.
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../sfo_concepts/ground_set.hpp"
+
+namespace solution
+{
+    template <typename E>
+    class SolutionPath
+    {
+        /* Greedy under a cardinality constraint selects the same elements in the same order whatever the budget,
+         *  so one run to k_max holds the greedy solution for every k <= k_max as a prefix: prefix(k) and value(k)
+         *  cost nothing beyond copying the prefix out. Steps are kept as ground set ids, with the gain of each
+         *  step and the value reached after it. Only greedy with a fixed order of choices has this property
+         *  (VanillaGreedy and LazyGreedy without cost-benefit), and the other constraints a run had still apply
+         *  to every prefix.
+         */
+    public:
+        groundset::GroundSet<E> *ground_set = nullptr; // the ids below refer to it
+        std::vector<uint32_t> ids;                     // selected ids, in selection order
+        std::vector<double> gains;                     // marginal gain of each step
+        std::vector<double> values;                    // value after each step
+        double empty_value = 0;                        // value of the empty set
+
+        void clear(groundset::GroundSet<E> *V, const double &value)
+        {
+            // starts a new path over V from the empty set, whose value is value
+            this->ground_set = V;
+            this->ids.clear();
+            this->gains.clear();
+            this->values.clear();
+            this->empty_value = value;
+        }
+
+        void record(const uint32_t &id, const double &value)
+        {
+            // id was selected, bringing the value to value
+            this->gains.push_back(value - this->value(this->size()));
+            this->ids.push_back(id);
+            this->values.push_back(value);
+        }
+
+        std::size_t size() const
+        {
+            return ids.size();
+        }
+
+        double value(const std::size_t &k) const
+        {
+            // value of the first k selections, the empty set's for k = 0
+            return (k == 0) ? empty_value : values[std::min(k, size()) - 1];
+        }
+
+        std::unordered_set<E *> prefix(std::size_t k) const
+        {
+            // the first k selected elements, all of them if k is larger than the path
+            k = std::min(k, size());
+            std::unordered_set<E *> set;
+            set.reserve(k);
+            for (std::size_t i = 0; i < k; i++)
+            {
+                set.insert((*ground_set)[ids[i]]);
+            }
+            return set;
+        }
+
+        void write(std::ostream &os) const
+        {
+            /* Binary, in host byte order: the number of steps (uint64), the empty set's value (double), then an
+             *  id (uint32) and the value after it (double) per step, 12 bytes a step. Gains are recomputed on read.
+             */
+            uint64_t count = size();
+            os.write(reinterpret_cast<const char *>(&count), sizeof(count));
+            os.write(reinterpret_cast<const char *>(&empty_value), sizeof(empty_value));
+            for (std::size_t i = 0; i < size(); i++)
+            {
+                os.write(reinterpret_cast<const char *>(&ids[i]), sizeof(uint32_t));
+                os.write(reinterpret_cast<const char *>(&values[i]), sizeof(double));
+            }
+        }
+
+        bool read(std::istream &is, groundset::GroundSet<E> *V)
+        {
+            /* Replaces the path with one written by write over the same ground set V. Returns false, leaving the
+             *  path as it was, if is runs out or holds an id that is not in V.
+             */
+            uint64_t count = 0;
+            double value = 0;
+            if (!is.read(reinterpret_cast<char *>(&count), sizeof(count)) || !is.read(reinterpret_cast<char *>(&value), sizeof(value)))
+            {
+                return false;
+            }
+            SolutionPath<E> result;
+            result.clear(V, value);
+            for (uint64_t i = 0; i < count; i++)
+            {
+                uint32_t id = 0;
+                if (!is.read(reinterpret_cast<char *>(&id), sizeof(id)) || !is.read(reinterpret_cast<char *>(&value), sizeof(value)))
+                {
+                    return false;
+                }
+                if (id >= V->size())
+                {
+                    return false;
+                }
+                result.record(id, value);
+            }
+            std::swap(*this, result);
+            return true;
+        }
+    };
+}
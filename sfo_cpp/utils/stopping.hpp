@@ -0,0 +1,124 @@
+// Limits on how long an optimizer keeps adding elements.
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "telemetry.hpp"
+
+namespace stopping
+{
+    enum class StopReason
+    {
+        NONE,            // ran until the constraints were saturated or nothing had positive gain
+        MAX_ELEMENTS,    // the set reached max_elements
+        DEADLINE,        // max_seconds of wall time passed
+        MAX_EVALUATIONS, // max_oracle_evaluations were spent
+        MIN_GAIN,        // an iteration gained less than min_gain
+        PLATEAU          // plateau_iterations iterations in a row gained little relative to the value
+    };
+
+    class StoppingPolicy
+    {
+        /* Limits of a run. Whichever is hit first ends it and the optimizer keeps the best set found so far.
+         *  Every limit is off by default. The limits are checked between iterations, and max_seconds and
+         *  max_oracle_evaluations also within one (see interrupt), so a single long iteration cannot overrun them.
+         */
+    public:
+        std::size_t max_elements = std::numeric_limits<std::size_t>::max();
+        double max_seconds = std::numeric_limits<double>::infinity(); // wall time since the run started
+        uint64_t max_oracle_evaluations = std::numeric_limits<uint64_t>::max();
+        double min_gain = -std::numeric_limits<double>::infinity(); // stop after an iteration gaining less
+        double plateau_tolerance = 0;                               // stop once gain <= tolerance * |value| ...
+        int plateau_iterations = 1;                                 // ... this many iterations in a row
+
+        StopReason reason = StopReason::NONE; // why the last run stopped
+
+        void start()
+        {
+            // called by the optimizer when a run starts
+            started = std::chrono::steady_clock::now();
+            reason = StopReason::NONE;
+            plateau_count = 0;
+            checked_iterations = 0;
+        }
+
+        bool reached(const telemetry::OptimizerStats &stats, const std::size_t &set_size, const double &value)
+        {
+            /* Checked before every iteration with the run's counters so far, the size of the set the next
+             *  iteration would grow and its value. Sets reason and returns true once a limit is hit.
+             */
+            if (set_size >= max_elements)
+            {
+                reason = StopReason::MAX_ELEMENTS;
+            }
+            else if (stats.oracle_evaluations >= max_oracle_evaluations)
+            {
+                reason = StopReason::MAX_EVALUATIONS;
+            }
+            else if (past_deadline())
+            {
+                reason = StopReason::DEADLINE;
+            }
+            else if (stats.iterations.size() > checked_iterations)
+            {
+                // only the iterations recorded since the last check
+                for (; checked_iterations < stats.iterations.size(); checked_iterations++)
+                {
+                    double gain = stats.iterations[checked_iterations].gain;
+                    if (gain < min_gain)
+                    {
+                        reason = StopReason::MIN_GAIN;
+                    }
+                    plateau_count = (plateau_tolerance > 0 && gain <= plateau_tolerance * std::abs(value)) ? plateau_count + 1 : 0;
+                }
+                if (reason == StopReason::NONE && plateau_tolerance > 0 && plateau_count >= plateau_iterations)
+                {
+                    reason = StopReason::PLATEAU;
+                }
+            }
+            return reason != StopReason::NONE;
+        }
+
+        StopReason hard_limit(const uint64_t &evaluations) const
+        {
+            /* Whether an iteration in progress has to be abandoned: once spending evaluations oracle calls in
+             *  total would pass max_oracle_evaluations, or the deadline has passed. Only reads the policy, so
+             *  threads scanning parts of the same iteration may ask at once.
+             */
+            if (evaluations > max_oracle_evaluations)
+            {
+                return StopReason::MAX_EVALUATIONS;
+            }
+            else if (past_deadline())
+            {
+                return StopReason::DEADLINE;
+            }
+            return StopReason::NONE;
+        }
+
+        bool interrupt(const uint64_t &evaluations)
+        {
+            /* Checked within an iteration, before spending oracle calls so evaluations would be spent in total.
+             *  Sets reason and returns true if the iteration has to be abandoned, keeping the set it started from.
+             */
+            if (reason == StopReason::NONE)
+            {
+                reason = hard_limit(evaluations);
+            }
+            return reason != StopReason::NONE;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        int plateau_count = 0;
+        std::size_t checked_iterations = 0;
+
+        bool past_deadline() const
+        {
+            return max_seconds < std::numeric_limits<double>::infinity() &&
+                   std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count() >= max_seconds;
+        }
+    };
+}
@@ -0,0 +1,316 @@
+// Lightweight instrumentation shared by the optimizers.
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Highest trace level compiled into the optimizers: 0 off, 1 run summaries, 2 iterations, 3 debug dumps of sets.
+// Anything above it compiles out entirely. Below it, nothing is traced unless a sink is attached.
+#ifndef SFO_TRACE_LEVEL
+#define SFO_TRACE_LEVEL 2
+#endif
+
+namespace telemetry
+{
+    struct IterationStats
+    {
+        double seconds = 0; // wall time of the iteration
+        double gain = 0;    // value added by the element chosen in it (0 if none was)
+    };
+
+    struct OptimizerStats
+    {
+        /* Counters of the last run of an optimizer. They are plain increments on the optimizer's own thread
+         *  (parallel scans count into per-thread copies that are added up afterwards), so they are cheap enough
+         *  to always keep on.
+         */
+        uint64_t oracle_evaluations = 0; // marginal gains and full evaluations asked of the cost function
+        uint64_t constraint_checks = 0;  // can_add calls
+        uint64_t queue_pushes = 0;       // lazy queue pushes
+        uint64_t queue_pops = 0;         // lazy queue pops
+        uint64_t queue_updates = 0;      // lazy queue entries re-evaluated and sifted in place
+        uint64_t reevaluations = 0;      // stale lazy queue entries whose marginal was recomputed
+        uint64_t samples_drawn = 0;      // elements drawn by the stochastic optimizers
+        std::vector<IterationStats> iterations;
+
+        void clear()
+        {
+            oracle_evaluations = 0;
+            constraint_checks = 0;
+            queue_pushes = 0;
+            queue_pops = 0;
+            queue_updates = 0;
+            reevaluations = 0;
+            samples_drawn = 0;
+            iterations.clear();
+        }
+
+        void add_counts(const OptimizerStats &other)
+        {
+            // adds the counters (not the iterations) of other, e.g. one thread's share of a scan
+            oracle_evaluations = oracle_evaluations + other.oracle_evaluations;
+            constraint_checks = constraint_checks + other.constraint_checks;
+            queue_pushes = queue_pushes + other.queue_pushes;
+            queue_pops = queue_pops + other.queue_pops;
+            queue_updates = queue_updates + other.queue_updates;
+            reevaluations = reevaluations + other.reevaluations;
+            samples_drawn = samples_drawn + other.samples_drawn;
+        }
+
+        double total_seconds() const
+        {
+            double seconds = 0;
+            for (auto &iteration : iterations)
+            {
+                seconds = seconds + iteration.seconds;
+            }
+            return seconds;
+        }
+    };
+
+    class IterationTimer
+    {
+        // times one iteration, from construction until record is called
+    public:
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        void record(OptimizerStats &stats, const double &gain) const
+        {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            stats.iterations.push_back({elapsed.count(), gain});
+        }
+    };
+
+    struct LatencyStats
+    {
+        // running summary of per-element processing times, constant size however many elements are timed
+        uint64_t count = 0;
+        double total_seconds = 0;
+        double max_seconds = 0;
+        double last_seconds = 0;
+
+        void clear()
+        {
+            count = 0;
+            total_seconds = 0;
+            max_seconds = 0;
+            last_seconds = 0;
+        }
+
+        void record(const double &seconds)
+        {
+            count++;
+            total_seconds = total_seconds + seconds;
+            max_seconds = (seconds > max_seconds) ? seconds : max_seconds;
+            last_seconds = seconds;
+        }
+
+        double mean_seconds() const
+        {
+            return (count > 0) ? total_seconds / count : 0;
+        }
+    };
+
+    enum class TraceLevel
+    {
+        OFF = 0,
+        RUN = 1,       // one event per run
+        ITERATION = 2, // one event per greedy iteration
+        DEBUG = 3      // formatted dumps of the current set and samples, expensive at scale
+    };
+
+    constexpr bool compiled(const TraceLevel &level)
+    {
+        return int(level) <= SFO_TRACE_LEVEL;
+    }
+
+    struct IterationEvent
+    {
+        const char *optimizer;
+        int iteration;
+        std::size_t set_size;
+        double value;                // value of the current set
+        double gain;                 // value added in this iteration
+        double seconds;              // wall time of this iteration
+        uint64_t oracle_evaluations; // so far in this run
+        bool saturated;
+    };
+
+    struct RunEvent
+    {
+        const char *optimizer;
+        std::size_t iterations;
+        std::size_t set_size;
+        double value;
+        double seconds;
+        uint64_t oracle_evaluations;
+    };
+
+    class TraceSink
+    {
+        // Receives trace events from the optimizers it is attached to, up to its level.
+    public:
+        TraceLevel level = TraceLevel::ITERATION;
+
+        virtual ~TraceSink(){};
+        virtual void run(const RunEvent &) {}
+        virtual void iteration(const IterationEvent &) {}
+        virtual void message(const TraceLevel &, const std::string &) {}
+    };
+
+    class TextSink : public TraceSink
+    {
+        // human readable lines, like the optimizers used to print
+    public:
+        std::ostream *os;
+
+        TextSink(std::ostream &out, const TraceLevel &l = TraceLevel::ITERATION)
+        {
+            os = &out;
+            level = l;
+        }
+
+        void run(const RunEvent &event)
+        {
+            (*os) << "Finished " << event.optimizer << " after " << event.iterations << " iterations" << std::endl;
+            (*os) << "Final val: " << event.value << std::endl;
+        }
+
+        void iteration(const IterationEvent &event)
+        {
+            (*os) << "Performed " << event.optimizer << " algorithm iteration: " << event.iteration << std::endl;
+            (*os) << "Current val: " << event.value << std::endl;
+            (*os) << "Constraint saturated? " << event.saturated << std::endl;
+        }
+
+        void message(const TraceLevel &, const std::string &text)
+        {
+            (*os) << text << std::endl;
+        }
+    };
+
+    class JsonLinesSink : public TraceSink
+    {
+        // one JSON object per event and line, for machine consumption
+    public:
+        std::ostream *os;
+
+        JsonLinesSink(std::ostream &out, const TraceLevel &l = TraceLevel::ITERATION)
+        {
+            os = &out;
+            level = l;
+        }
+
+        void run(const RunEvent &event)
+        {
+            (*os) << "{\"event\":\"run\",\"optimizer\":\"" << event.optimizer << "\",\"iterations\":" << event.iterations
+                  << ",\"set_size\":" << event.set_size << ",\"value\":" << number(event.value)
+                  << ",\"seconds\":" << number(event.seconds) << ",\"oracle_evaluations\":" << event.oracle_evaluations << "}\n";
+        }
+
+        void iteration(const IterationEvent &event)
+        {
+            (*os) << "{\"event\":\"iteration\",\"optimizer\":\"" << event.optimizer << "\",\"iteration\":" << event.iteration
+                  << ",\"set_size\":" << event.set_size << ",\"value\":" << number(event.value) << ",\"gain\":" << number(event.gain)
+                  << ",\"seconds\":" << number(event.seconds) << ",\"oracle_evaluations\":" << event.oracle_evaluations
+                  << ",\"saturated\":" << (event.saturated ? "true" : "false") << "}\n";
+        }
+
+        void message(const TraceLevel &l, const std::string &text)
+        {
+            (*os) << "{\"event\":\"message\",\"level\":" << int(l) << ",\"text\":\"";
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    (*os) << '\\' << c;
+                }
+                else if (c == '\n')
+                {
+                    (*os) << "\\n";
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    (*os) << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+                }
+                else
+                {
+                    (*os) << c;
+                }
+            }
+            (*os) << "\"}\n";
+        }
+
+    private:
+        static std::string number(const double &x)
+        {
+            // JSON has no inf or nan
+            if (!(x == x) || x > 1e308 || x < -1e308)
+            {
+                return "null";
+            }
+            std::ostringstream out;
+            out << std::setprecision(17) << x;
+            return out.str();
+        }
+    };
+
+    class Tracer
+    {
+        /* Held by each optimizer. Without a sink (the default) every call is a null check,
+         *  and levels above SFO_TRACE_LEVEL are discarded at compile time.
+         */
+    public:
+        TraceSink *sink = nullptr;
+
+        bool enabled(const TraceLevel &level) const
+        {
+            return compiled(level) && sink && int(level) <= int(sink->level);
+        }
+
+        void run(const char *optimizer, const OptimizerStats &stats, const std::size_t &set_size, const double &value) const
+        {
+            if constexpr (compiled(TraceLevel::RUN))
+            {
+                if (this->enabled(TraceLevel::RUN))
+                {
+                    sink->run({optimizer, stats.iterations.size(), set_size, value, stats.total_seconds(), stats.oracle_evaluations});
+                }
+            }
+        }
+
+        void iteration(const char *optimizer, const int &counter, const OptimizerStats &stats, const std::size_t &set_size, const double &value, const bool &saturated) const
+        {
+            // reports the iteration last recorded in stats
+            if constexpr (compiled(TraceLevel::ITERATION))
+            {
+                if (this->enabled(TraceLevel::ITERATION) && !stats.iterations.empty())
+                {
+                    const IterationStats &last = stats.iterations.back();
+                    sink->iteration({optimizer, counter, set_size, value, last.gain, last.seconds, stats.oracle_evaluations, saturated});
+                }
+            }
+        }
+
+        template <typename Fn>
+        void debug(Fn format) const
+        {
+            /* format(os) writes the message to a std::ostream. It is only called (or even instantiated,
+             *  if it is a generic lambda) when debug tracing is compiled in and enabled.
+             */
+            if constexpr (compiled(TraceLevel::DEBUG))
+            {
+                if (this->enabled(TraceLevel::DEBUG))
+                {
+                    std::ostringstream os;
+                    format(os);
+                    sink->message(TraceLevel::DEBUG, os.str());
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,124 @@
+// A small persistent pool of worker threads for the parallel optimizer modes.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel
+{
+    class WorkerPool
+    {
+        /* Runs batches of independent tasks on num_threads threads, the calling thread being one of them.
+         *  Threads are started once and sleep between batches, so a pool can be reused every greedy iteration
+         *  without paying for thread creation each time.
+         */
+    public:
+        WorkerPool(const int &num_threads)
+        {
+            for (int t = 1; t < std::max(1, num_threads); t++)
+            {
+                workers.emplace_back([this]()
+                                     { this->work(); });
+            }
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+        int size() const
+        {
+            return int(workers.size()) + 1;
+        }
+
+        void run(const int &num_tasks, const std::function<void(int)> &fn)
+        {
+            // calls fn(0), ..., fn(num_tasks - 1) across the pool and returns once all of them are done
+            if (workers.empty() || num_tasks <= 1)
+            {
+                for (int i = 0; i < num_tasks; i++)
+                {
+                    fn(i);
+                }
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                task = &fn;
+                total_tasks = num_tasks;
+                next_task = 0;
+                busy_workers = int(workers.size());
+                generation++;
+            }
+            wake.notify_all();
+
+            this->drain();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]()
+                      { return busy_workers == 0; });
+            task = nullptr;
+        }
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake; // signals workers that a batch (or shutdown) is ready
+        std::condition_variable done; // signals the caller that every worker finished the batch
+        const std::function<void(int)> *task = nullptr;
+        int total_tasks = 0;
+        std::atomic<int> next_task{0};
+        int busy_workers = 0;
+        unsigned long generation = 0;
+        bool stopping = false;
+
+        void drain()
+        {
+            // pull tasks until the batch runs out
+            for (int i = next_task++; i < total_tasks; i = next_task++)
+            {
+                (*task)(i);
+            }
+        }
+
+        void work()
+        {
+            unsigned long seen = 0;
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]()
+                              { return stopping || generation != seen; });
+                    if (stopping)
+                    {
+                        return;
+                    }
+                    seen = generation;
+                }
+
+                this->drain();
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    busy_workers--;
+                }
+                done.notify_one();
+            }
+        }
+    };
+}